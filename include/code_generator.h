@@ -12,7 +12,15 @@
 #include "code_generator/formatter.h"
 #include "code_generator/cpp_generator.h"
 #include "code_generator/config_parser.h"
+#include "code_generator/config_schema.h"
+#include "code_generator/config_validator.h"
+#include "code_generator/json_writer.h"
+#include "code_generator/binary_config.h"
+#include "code_generator/thread_pool.h"
+#include "code_generator/build_manifest.h"
+#include "code_generator/native_template.h"
 #include "code_generator/enhanced_cpp_generator.h"
+#include "code_generator/project_scheduler.h"
 
 /**
  * @namespace code_generator
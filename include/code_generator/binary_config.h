@@ -0,0 +1,51 @@
+#ifndef CODE_GENERATOR_BINARY_CONFIG_H
+#define CODE_GENERATOR_BINARY_CONFIG_H
+
+#include <boost/filesystem.hpp>
+#include <boost/json.hpp>
+#include <string>
+
+namespace code_generator {
+
+namespace json = boost::json;
+
+// 配置文件的编码格式
+enum class ConfigFormat {
+	JSON,
+	CBOR,
+	MESSAGE_PACK
+};
+
+const char* ConfigFormatName(ConfigFormat format);
+
+// 由程序生成的配置可以用CBOR或MessagePack编码，直接解码为json::value，
+// 之后的导入、变量替换和FromJson与JSON配置完全相同
+// 只支持JSON能表示的数据：字节串、扩展类型和非字符串的键视为错误
+class BinaryConfigCodec {
+public:
+	// 按开头的字节识别格式：配置的顶层必须是对象，CBOR的对象以0xa0-0xbf或自描述标签0xd9d9f7开头，
+	// MessagePack的对象以0x80-0x8f、0xde或0xdf开头，都不可能是JSON文本的开头
+	static ConfigFormat Detect(const char* data, size_t size);
+
+	// .json、.cbor、.msgpack/.mpk，无法识别时返回false
+	static bool FormatFromExtension(const boost::filesystem::path& path, ConfigFormat* format);
+
+	// 解码结果分配在value->storage()上：调用方用内存池构造value，解码过程中直接在池中分配，
+	// 不会再整体拷贝一次；失败时返回false并给出出错位置，value中可能留有部分结果
+	static bool Decode(ConfigFormat format, const char* data, size_t size, json::value* value, std::string* error);
+
+	// 按输入的格式解析，JSON文本交给json::parse，同样分配在value->storage()上
+	static bool Parse(const char* data, size_t size, json::value* value, std::string* error);
+
+	// 整数优先使用最短的编码；CBOR输出以自描述标签开头
+	static void Encode(ConfigFormat format, const json::value& value, std::string* output);
+
+	// 在JSON、CBOR和MessagePack之间转换配置文件，输入格式按内容识别，输出格式按扩展名确定
+	// 只转换编码，不展开导入和变量
+	static bool ConvertFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+							std::string* error);
+};
+
+} // namespace code_generator
+
+#endif
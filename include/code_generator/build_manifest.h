@@ -0,0 +1,56 @@
+#ifndef CODE_GENERATOR_BUILD_MANIFEST_H
+#define CODE_GENERATOR_BUILD_MANIFEST_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace code_generator {
+
+// 64位FNV-1a指纹，用于判断生成输入是否变化
+class Fingerprint {
+public:
+	Fingerprint() : hash_(kOffsetBasis) {}
+
+	// 先混入长度再混入内容，避免"ab"+"c"与"a"+"bc"得到相同结果
+	Fingerprint& Update(const std::string& data);
+	Fingerprint& Update(const char* data, size_t size);
+	Fingerprint& Update(uint64_t value);
+
+	uint64_t Value() const { return hash_; }
+	std::string ToHex() const;
+
+private:
+	static const uint64_t kOffsetBasis = 14695981039346656037ULL;
+	static const uint64_t kPrime = 1099511628211ULL;
+
+	uint64_t hash_;
+};
+
+// 增量生成清单：记录输出目录中每个生成文件对应的输入指纹
+// 文件格式为首行版本头，之后每行"<指纹> <文件名>"
+class BuildManifest {
+public:
+	static const char* kFileName;
+	// 项目版本加输出修订号，如"1.0.0+r1"；变化时旧清单会整体失效
+	static const char* kGeneratorVersion;
+
+	// 文件不存在或版本不匹配时返回false，清单为空
+	bool Load(const std::string& path);
+	bool Save(const std::string& path) const;
+
+	// 未记录时返回空字符串
+	std::string Get(const std::string& filename) const;
+	void Set(const std::string& filename, const std::string& fingerprint);
+	void Remove(const std::string& filename);
+	void Clear() { entries_.clear(); }
+
+	size_t Size() const { return entries_.size(); }
+
+private:
+	std::map<std::string, std::string> entries_;
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef CODE_GENERATOR_CODE_LIBRARY_CACHE_H
+#define CODE_GENERATOR_CODE_LIBRARY_CACHE_H
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/utility/string_view.hpp>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace code_generator {
+
+// 以只读内存映射方式驻留的库文件内容
+class MappedFile : private boost::noncopyable {
+public:
+	// 映射失败时抛出异常
+	explicit MappedFile(const std::string& path);
+
+	const char* data() const { return data_; }
+	size_t size() const { return size_; }
+	// 直接指向映射内容，在MappedFile存在期间有效
+	boost::string_view view() const { return boost::string_view(data_, size_); }
+
+private:
+	boost::interprocess::mapped_region region_;
+	const char* data_;
+	size_t size_;
+};
+
+// 代码库文件缓存，可在多个生成器、多个线程间共享
+// 文件以内存映射方式常驻，同一版本只打开一次；文件的mtime/inode/大小变化后重新映射
+// 映射总字节数超过预算时按LRU淘汰，正在被使用的映射由shared_ptr保持有效
+class CodeLibraryCache : private boost::noncopyable {
+public:
+	typedef std::shared_ptr<const MappedFile> Content;
+
+	static const size_t kDefaultByteBudget = 256 * 1024 * 1024;
+
+	explicit CodeLibraryCache(size_t byte_budget = kDefaultByteBudget);
+
+	// 文件不存在或映射失败返回空指针
+	Content Get(const std::string& path);
+
+	void SetByteBudget(size_t byte_budget);
+	size_t Size() const;
+	size_t Bytes() const;
+	void Clear();
+
+private:
+	// 用于判断文件是否被修改或替换
+	struct FileStamp {
+		uint64_t inode = 0;
+		int64_t mtime_ns = 0;
+		uint64_t size = 0;
+
+		bool operator==(const FileStamp& other) const {
+			return inode == other.inode && mtime_ns == other.mtime_ns && size == other.size;
+		}
+		bool operator!=(const FileStamp& other) const { return !(*this == other); }
+	};
+
+	struct Entry {
+		FileStamp stamp;
+		std::once_flag once;
+		Content content;
+		// 在表锁之外也会被读取
+		std::atomic<bool> counted{false};
+		std::list<std::string>::iterator lru_position;
+	};
+
+	mutable std::mutex mutex_;
+	std::map<std::string, std::shared_ptr<Entry>> entries_;
+	// 队首为最近使用
+	std::list<std::string> lru_;
+	size_t byte_budget_;
+	size_t total_bytes_;
+
+	static bool StatFile(const std::string& path, FileStamp* stamp);
+	static Content MapFile(const std::string& path);
+
+	void EraseLocked(std::map<std::string, std::shared_ptr<Entry>>::iterator it);
+	void EvictLocked(const std::string& keep);
+};
+
+} // namespace code_generator
+
+#endif
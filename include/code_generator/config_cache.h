@@ -0,0 +1,50 @@
+#ifndef CODE_GENERATOR_CONFIG_CACHE_H
+#define CODE_GENERATOR_CONFIG_CACHE_H
+
+#include "config_parser.h"
+#include "template_engine.h"
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace code_generator {
+
+// 编译后配置的二进制缓存：保存变量替换后的ProjectConfig和预编译模板的字节码，
+// 读取时内存映射缓存文件并顺序反序列化，不做JSON解析
+// 文件格式（本机字节序，仅供同一台机器复用）：
+//   "CGCC" | 格式版本(u32) | 键(u64) | 数据长度(u64) | 导入文件及指纹 | 配置 | 模板字节码
+// 键只覆盖配置文件本身，导入的文件在读取时逐个比较指纹
+// 每个配置文件对应一个缓存文件，文件名由配置文件的绝对路径计算
+class ConfigCache {
+public:
+	// 序列化格式变化时需要递增
+	static const uint32_t kFormatVersion = 2;
+
+	explicit ConfigCache(const boost::filesystem::path& directory) : directory_(directory) {}
+
+	// 配置文件原文、格式版本和生成器版本的指纹；解析逻辑变化时须递增BuildManifest::kGeneratorVersion
+	static uint64_t ComputeKey(const std::string& content);
+
+	boost::filesystem::path CachePath(const boost::filesystem::path& config_file) const;
+
+	// 缓存不存在、键不匹配、导入的文件已修改或内容损坏时返回false，输出参数不变
+	bool Load(const boost::filesystem::path& config_file, uint64_t key, std::map<std::string, uint64_t>* imported_files,
+			  CodeGenConfig::ProjectConfig* config, FlatStringMap<CompiledTemplate>* templates) const;
+
+	// 先写入临时文件再重命名，并发写入同一缓存时读方不会看到不完整的文件
+	bool Store(const boost::filesystem::path& config_file, uint64_t key,
+			   const std::map<std::string, uint64_t>& imported_files, const CodeGenConfig::ProjectConfig& config,
+			   const FlatStringMap<CompiledTemplate>& templates, std::string* error) const;
+
+private:
+	boost::filesystem::path directory_;
+
+	// 模板原文取自code_templates，只保存字节码
+	static void WriteProgram(const CompiledTemplate& compiled, std::string* buffer);
+	static bool ReadProgram(const char** data, const char* end, CompiledTemplate* compiled);
+};
+
+} // namespace code_generator
+
+#endif
@@ -2,10 +2,15 @@
 #define CODE_GENERATOR_CONFIG_PARSER_H
 
 #include "cpp_generator.h"
+#include "flat_string_map.h"
+#include "native_template.h"
+#include "template_engine.h"
+#include "variable_resolver.h"
 #include <boost/json.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
+#include <functional>
 #include <string>
 #include <vector>
 #include <map>
@@ -15,18 +20,14 @@ namespace code_generator {
 
 namespace json = boost::json;
 
+class JsonWriter;
+class MappedFile;
+struct ConfigDiagnostic;
+struct ConfigOutputPaths;
+
 // 配置数据结构
+// 各结构体的FromJson/ToJson由config_schema.cpp中的描述生成（src/config_json.cpp），增删字段时需同步描述并重新生成
 struct CodeGenConfig {
-	struct ClassConfig {
-		std::string name;
-		std::vector<std::string> base_classes;
-		std::vector<std::string> templates;
-		std::map<std::string, std::string> metadata;
-
-		static ClassConfig FromJson(const json::value& json);
-		json::value ToJson() const;
-	};
-
 	struct FunctionConfig {
 		std::string name;
 		std::string return_type;
@@ -41,6 +42,7 @@ struct CodeGenConfig {
 
 		static FunctionConfig FromJson(const json::value& json);
 		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
 	};
 
 	struct MemberConfig {
@@ -52,11 +54,40 @@ struct CodeGenConfig {
 
 		static MemberConfig FromJson(const json::value& json);
 		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
+	};
+
+	struct ClassConfig {
+		std::string name;
+		std::vector<std::string> base_classes;
+		std::vector<std::string> templates;
+		std::map<std::string, std::string> metadata;
+		std::vector<FunctionConfig> functions;
+		std::vector<MemberConfig> members;
+
+		static ClassConfig FromJson(const json::value& json);
+		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
+	};
+
+	// 代码片段：引用名和插入位置
+	// 插入位置：after_includes、namespace_begin、namespace_end、end_of_file（默认）
+	// dual模式下target可选header（默认）或source
+	struct SnippetConfig {
+		std::string reference;
+		std::string anchor = "end_of_file";
+		std::string target = "header";
+
+		// 兼容旧格式：字符串等价于插入到文件末尾
+		static SnippetConfig FromJson(const json::value& json);
+		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
 	};
 
 	struct FileConfig {
 		std::string filename;
-		std::string type; // "header" or "source"
+		std::string type; // "header", "source" or "dual"
+		std::string source_filename; // "dual"模式下的源文件名，为空时由filename推导
 		std::vector<std::string> includes;
 		std::vector<std::string> namespaces;
 		std::vector<ClassConfig> classes;
@@ -64,26 +95,34 @@ struct CodeGenConfig {
 		std::vector<MemberConfig> globals;
 		std::map<std::string, std::string> templates;
 		std::vector<std::string> copy_files;
-		std::vector<std::string> insert_snippets;
+		std::vector<SnippetConfig> insert_snippets;
 
 		static FileConfig FromJson(const json::value& json);
 		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
 	};
 
+	// imports中的文件按相对于当前配置文件的路径加载，合并其中的common_includes、variables和
+	// code_templates：当前配置优先，后面的导入优先于前面的导入，被导入文件可以继续导入。
+	// 保存时输出合并后的内容，不再输出imports
 	struct ProjectConfig {
 		std::string name;
 		std::string version;
 		std::string output_dir;
+		std::vector<std::string> imports;
 		std::vector<FileConfig> files;
-		std::map<std::string, std::string> variables;
+		StringMap variables;
+		// 非字符串变量（数组、对象等），供模板中的{{#each}}/{{#if}}使用
+		json::object structured_variables;
 		std::vector<std::string> common_includes;
-		std::map<std::string, std::string> code_templates;
+		StringMap code_templates;
 
 		static ProjectConfig FromJson(const json::value& json);
 		json::value ToJson() const;
+		void WriteJson(JsonWriter& writer) const;
 	};
 
-	static void LoadVariables(const json::value& json, std::map<std::string, std::string>& variables);
+	static void LoadVariables(const json::value& json, StringMap& variables);
 };
 
 // 配置解析器
@@ -94,53 +133,131 @@ public:
 	// 从文件加载配置
 	bool LoadFromFile(const boost::filesystem::path& filename);
 
+	// 设置后LoadFromFile先查找编译后配置的二进制缓存，配置文件未变化时跳过JSON解析，
+	// 未命中时正常解析并写入缓存；为空时不使用缓存（默认）
+	void SetCacheDirectory(const boost::filesystem::path& directory) { cache_directory_ = directory; }
+
+	// 加载时是否校验配置（默认开启），关闭后由调用方在加载完成后自行校验，
+	// 校验失败的配置也能加载，以便一次报告所有问题
+	void SetValidateOnLoad(bool enable) { validate_on_load_ = enable; }
+
 	// 从字符串加载配置
 	bool LoadFromString(const std::string& json_str);
 
-	// 从JSON值加载配置
+	// 从JSON值加载配置，不处理imports
 	bool LoadFromJson(const json::value& json);
 
+	// 流式加载：文件以内存映射方式读取并逐事件解析，files中的每个元素解析完成后立即转换为
+	// FileConfig交给on_file，不保留完整文档和文件列表，GetProjectConfig().files为空。
+	// files之前的项目设置解析完成后先调用on_project；name、variables等设置出现在files之后时加载失败。
+	// 回调返回false时停止解析
+	typedef std::function<bool(const CodeGenConfig::ProjectConfig& project_config)> ProjectCallback;
+	typedef std::function<bool(CodeGenConfig::FileConfig&& file_config)> FileCallback;
+	bool LoadStreaming(const boost::filesystem::path& filename, const ProjectCallback& on_project,
+					   const FileCallback& on_file);
+	// 流式加载时每个文件的校验同时检查引用的模板和library::component，未设置时不检查引用。
+	// 跨文件的重复输出路径总是在文件到达时检查
+	typedef std::function<bool(const std::string& reference, std::string* reason)> ReferenceChecker;
+	void SetStreamReferenceChecker(ReferenceChecker checker) { stream_reference_checker_ = std::move(checker); }
+
 	// 获取项目配置
 	const CodeGenConfig::ProjectConfig& GetProjectConfig() const { return project_config_; }
 
-	// 变量替换
+	// 最近一次加载直接或间接导入的文件（规范化的绝对路径）及其内容指纹
+	const std::map<std::string, uint64_t>& GetImportedFiles() const { return imported_files_; }
+
+	// 变量替换，支持${A_${B}}间接引用
 	std::string ReplaceVariables(const std::string& text) const;
-	void ReplaceBufferByVariables(std::string& strjson, std::map<std::string, std::string>& variables);
 
-	// 获取代码模板
-	std::string GetTemplate(const std::string& name) const;
+	// 获取代码模板（已替换项目变量）
+	std::string GetTemplate(boost::string_view name) const;
+	// 加载配置时预编译的模板，不存在时返回nullptr
+	const CompiledTemplate* GetCompiledTemplate(boost::string_view name) const;
+	const VariableTable& GetVariableTable() const { return variable_table_; }
 
 	// 应用模板并替换变量
 	std::string ApplyTemplate(const std::string& template_name, 
 				const std::map<std::string, std::string>& variables = {}) const;
 
-	// 验证配置
+	// 验证配置，所有错误一次写入错误信息，每条一行
 	bool ValidateConfig() const;
+	// 同时把每条问题追加到diagnostics；不检查模板和代码库引用，完整的检查见EnhancedCppGenerator::ValidateConfig
+	bool ValidateConfig(std::vector<ConfigDiagnostic>* diagnostics) const;
 
 	// 获取错误信息
 	const std::string& GetError() const { return error_message_; }
 
 	// 保存配置到文件
-	bool SaveToFile(const boost::filesystem::path& filename) const;
+	bool SaveToFile(const boost::filesystem::path& filename, bool pretty = true) const;
 
 	// 生成配置JSON字符串
 	std::string ToJsonString(bool pretty = true) const;
 
+	// 遍历配置结构体直接输出JSON，不构造json::value树
+	bool WriteJson(ZeroCopyOutputStream* output, bool pretty = true) const;
+
 private:
 	CodeGenConfig::ProjectConfig project_config_;
-	std::map<std::string, std::string> variables_;
+	StringMap variables_;
+	VariableTable variable_table_;
+	FlatStringMap<CompiledTemplate> compiled_templates_;
+	// 模板原文未变时使用预先生成的原生渲染函数
+	FlatStringMap<NativeTemplateRenderer> native_templates_;
+	boost::filesystem::path cache_directory_;
+	bool validate_on_load_ = true;
+	std::map<std::string, uint64_t> imported_files_;
 	std::string error_message_;
 
-	void BuildVariableMap();
+	// 流式加载时files之前的变量，用于替换每个文件元素中的${NAME}，已展开的变量在文件间复用
+	VariableResolver stream_resolver_;
+	bool stream_has_variables_ = false;
+	// 流式加载时imports的相对路径基准
+	boost::filesystem::path stream_directory_;
+	// 流式加载中已经过的文件的输出路径
+	std::shared_ptr<ConfigOutputPaths> stream_outputs_;
+	ReferenceChecker stream_reference_checker_;
+
+	class StreamHandler;
+	bool BeginStream(json::value* header, const ProjectCallback& on_project);
+	bool StreamFile(json::value* file_json, const FileCallback& on_file);
+	// CBOR/MessagePack配置整体解码后按BeginStream、StreamFile的顺序回调
+	bool StreamDecoded(const MappedFile& mapped, const ProjectCallback& on_project, const FileCallback& on_file);
+
+	// 按文本长度预分配内存池并解析，文本也可以是CBOR或MessagePack，解析失败时设置错误信息。
+	// 内存池只用于解析期间的文档，CodeGenConfig中的字符串仍然拷贝出来，不引用池中的数据
+	bool ParseDocument(const std::string& text, std::shared_ptr<json::value>* document);
+	// 把imports中的文档合并到document，导入的文档从ImportCache获取，不重复解析
+	bool ResolveImports(json::value* document, const boost::filesystem::path& base_directory);
+	bool MergeImports(json::object* target, const std::vector<std::string>& imports,
+					  const boost::filesystem::path& base_directory, std::vector<std::string>* import_stack);
+	static void MergeImportedSections(json::object* target, const json::object& source);
+	// 项目变量与内置变量一起展开，TIMESTAMP等计算变量在展开时求值；有循环引用时返回false
+	bool BuildVariableMap();
+	// 遍历所有字符串值替换${NAME}，顶层code_templates除外；有循环引用时返回false
+	bool SubstituteVariables(json::value* json, VariableResolver* resolver);
+	bool CompileTemplates();
+	void FindNativeTemplates();
+	// 缓存命中时恢复配置和预编译模板，运行时变量（如TIMESTAMP）重新计算
+	bool LoadFromCache(const boost::filesystem::path& filename, uint64_t key);
+	// 流式加载时逐个文件校验，并检查输出路径与之前的文件是否重复
+	bool ValidateFileConfig(const CodeGenConfig::FileConfig& file_config);
+	// diagnostics中从begin开始的错误，每条一行
+	static std::string FormatErrors(const std::vector<ConfigDiagnostic>& diagnostics, size_t begin);
 	std::string ProcessTemplate(const std::string& template_text) const;
 	void SetError(const std::string& error);
 
 public:
 	// JSON辅助方法
+	// 按长度拷贝，不经过c_str()再计算长度
+	static std::string JsonToString(const json::value& value);
 	static std::vector<std::string> JsonArrayToStringVector(const json::value& array);
 	static std::map<std::string, std::string> JsonObjectToStringMap(const json::value& object);
+	static void JsonObjectToStringMap(const json::value& object, std::map<std::string, std::string>* map);
+	// 保持JSON中的顺序
+	static void JsonObjectToStringMap(const json::value& object, StringMap* map);
 	static json::value StringVectorToJsonArray(const std::vector<std::string>& vec);
 	static json::value StringMapToJsonObject(const std::map<std::string, std::string>& map);
+	static json::value StringMapToJsonObject(const StringMap& map);
 };
 
 } // namespace code_generator
@@ -0,0 +1,73 @@
+#ifndef CODE_GENERATOR_CONFIG_SCHEMA_H
+#define CODE_GENERATOR_CONFIG_SCHEMA_H
+
+#include "cpp_generator.h"
+#include <boost/filesystem.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace code_generator {
+
+// CodeGenConfig中一个字段与JSON键的对应关系
+struct ConfigSchemaField {
+	enum class Kind {
+		STRING,			// std::string
+		BOOL,			// bool
+		STRING_ARRAY,	// std::vector<std::string>
+		STRING_MAP,		// std::map<std::string, std::string>或StringMap
+		STRUCT_ARRAY,	// std::vector<element>，元素有自己的FromJson/ToJson
+		PARAMETERS,		// std::vector<std::pair<type, name>>，JSON中为{"type", "name"}对象数组
+		VARIABLES		// StringMap加structured_variables，非字符串的值保存在后者
+	};
+
+	const char* key;
+	const char* member;
+	Kind kind;
+	const char* element;	// STRUCT_ARRAY的元素类型
+	bool omit_empty;		// 为空时ToJson不输出
+	bool read_only;			// 只由FromJson读取，ToJson/WriteJson不输出
+};
+
+struct ConfigSchemaStruct {
+	const char* name;		// CodeGenConfig中的结构体名
+	// 非空时JSON也可以直接给出字符串，等价于只设置这个字段；
+	// 其余字段都为默认值时ToJson/WriteJson同样输出字符串
+	const char* shorthand;
+	std::vector<ConfigSchemaField> fields;
+};
+
+// CodeGenConfig各结构体的描述，修改结构体字段后在这里同步，并重新生成src/config_json.cpp
+const std::vector<ConfigSchemaStruct>& GetConfigSchema();
+
+// 由配置描述生成FromJson/ToJson/WriteJson：FromJson只遍历一次对象成员，按键的哈希值switch分派到字段，
+// 不再对每个字段先contains再at；WriteJson通过JsonWriter直接输出，不构造json::value
+// 生成的源码随仓库提交，由cppcodegen --generate-config-json更新
+class ConfigSchemaCompiler {
+public:
+	explicit ConfigSchemaCompiler(const std::vector<ConfigSchemaStruct>& schema) : schema_(schema) {}
+
+	bool WriteFile(const boost::filesystem::path& path, std::string* error) const;
+
+	// FNV-1a，与生成代码中的ConfigKeyHash一致
+	static uint32_t KeyHash(boost::string_view key);
+
+private:
+	const std::vector<ConfigSchemaStruct>& schema_;
+
+	void WriteSource(CppGenerator& generator) const;
+	// 类型名驻留在生成器的symbols中
+	CppFunction BuildFromJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const;
+	CppFunction BuildToJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const;
+	CppFunction BuildWriteJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const;
+
+	static void AppendFieldRead(const ConfigSchemaField& field, std::string* body);
+	static void AppendFieldWrite(const ConfigSchemaField& field, std::string* body);
+	static void AppendFieldStream(const ConfigSchemaField& field, std::string* body);
+	static const char* TypeCheck(ConfigSchemaField::Kind kind);
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef CODE_GENERATOR_CONFIG_VALIDATOR_H
+#define CODE_GENERATOR_CONFIG_VALIDATOR_H
+
+#include "config_parser.h"
+#include "thread_pool.h"
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace code_generator {
+
+// 一条校验结果，location形如"widget.h: class Widget: function Draw"
+struct ConfigDiagnostic {
+	enum class Severity {
+		ERROR,
+		WARNING
+	};
+
+	Severity severity;
+	std::string location;
+	std::string message;
+
+	std::string ToString() const;
+};
+
+// 流式加载中已出现的输出路径（相对输出目录），逐个文件校验时检查跨文件的重复路径
+struct ConfigOutputPaths {
+	// 路径 -> 生成它的配置文件名
+	std::unordered_map<std::string, std::string> generated;
+	// 复制到输出目录的文件 -> 复制它的配置文件名
+	std::unordered_map<std::string, std::string> copied;
+};
+
+// 配置校验：在生成之前检查整个项目，收集所有问题后一次返回，不在第一个错误处停止
+// 检查项：项目名和文件列表、文件名、重复的输出路径、代码片段位置、未定义的${VAR}、
+// 类模板/代码片段/@include/copy_files引用的模板和代码库组件
+// 各文件的检查相互独立，有线程池时并行执行，结果按文件顺序排列
+// 只读取内存中的配置；设置了引用检查时copy_files和代码库组件会检查文件是否存在
+class ConfigValidator {
+public:
+	// 检查模板名或library::component引用，无法解析时返回false并在reason中给出原因
+	// 并行校验时会被多个线程同时调用
+	typedef std::function<bool(const std::string& reference, std::string* reason)> ReferenceChecker;
+
+	explicit ConfigValidator(const CodeGenConfig::ProjectConfig& config) : config_(config) {}
+
+	// 已展开的变量表，设置后检查配置中残留的${VAR}
+	void SetVariables(const VariableTable* variables) { variables_ = variables; }
+	// 未设置时不检查引用；配置自身的code_templates总是可以被引用
+	void SetReferenceChecker(ReferenceChecker checker) { reference_checker_ = std::move(checker); }
+	void SetThreadPool(std::shared_ptr<ThreadPool> pool) { thread_pool_ = pool; }
+
+	// 没有ERROR级别的问题时返回true，所有问题按顺序追加到diagnostics
+	bool Validate(std::vector<ConfigDiagnostic>* diagnostics) const;
+	// 单个文件的检查，不包括跨文件的重复路径检查
+	bool ValidateFile(const CodeGenConfig::FileConfig& file_config, std::vector<ConfigDiagnostic>* diagnostics) const;
+	// 用于流式加载：另外检查输出路径是否与之前的文件重复，并把本文件的输出路径加入outputs
+	bool ValidateFile(const CodeGenConfig::FileConfig& file_config, ConfigOutputPaths* outputs,
+					  std::vector<ConfigDiagnostic>* diagnostics) const;
+
+	// dual模式下源文件的输出路径，未指定时由filename推导
+	static std::string SourceFilename(const CodeGenConfig::FileConfig& file_config);
+
+	static bool HasErrors(const std::vector<ConfigDiagnostic>& diagnostics);
+	// 每条一行
+	static void PrintReport(const std::vector<ConfigDiagnostic>& diagnostics, std::ostream& out);
+
+private:
+	const CodeGenConfig::ProjectConfig& config_;
+	const VariableTable* variables_ = nullptr;
+	ReferenceChecker reference_checker_;
+	std::shared_ptr<ThreadPool> thread_pool_;
+
+	void CheckFile(const CodeGenConfig::FileConfig& file_config, std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckClass(const CodeGenConfig::ClassConfig& class_config, const std::string& location,
+					std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckFunction(const CodeGenConfig::FunctionConfig& function, const std::string& location,
+					   std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckMember(const CodeGenConfig::MemberConfig& member, const std::string& location,
+					 std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckDuplicateOutputs(std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckStreamedOutputs(const CodeGenConfig::FileConfig& file_config, ConfigOutputPaths* outputs,
+							  std::vector<ConfigDiagnostic>* diagnostics) const;
+	// 报告text中未定义的${VAR}：名字、类型、文件名等结构性字段中为错误
+	void CheckVariables(const std::string& text, const std::string& location,
+						std::vector<ConfigDiagnostic>* diagnostics) const;
+	// 函数体、初始值和注释中未定义的${...}原样输出（可能是shell或JS模板文本），只给出警告
+	void CheckTextVariables(const std::string& text, const std::string& location,
+							std::vector<ConfigDiagnostic>* diagnostics) const;
+	void CheckVariables(const std::string& text, const std::string& location, ConfigDiagnostic::Severity severity,
+						std::vector<ConfigDiagnostic>* diagnostics) const;
+	// 报告text中无法解析的@include(reference)
+	void CheckIncludes(const std::string& text, const std::string& location,
+					   std::vector<ConfigDiagnostic>* diagnostics) const;
+	bool CheckReference(const std::string& reference, std::string* reason) const;
+};
+
+} // namespace code_generator
+
+#endif
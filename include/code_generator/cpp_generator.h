@@ -3,12 +3,57 @@
 #define CPP_GENERATOR_H
 
 #include "formatter.h"
+#include "symbol_table.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <utility>
+
+// C++17且标准库提供<memory_resource>时，模型容器改用std::pmr分配
+#if defined(ENABLE_CXX17) && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define CODE_GENERATOR_HAS_PMR 1
+#endif
+#endif
 
 namespace code_generator{
 
+#ifdef CODE_GENERATOR_HAS_PMR
+using ModelAllocator = std::pmr::polymorphic_allocator<char>;
+template<typename T>
+using ModelVector = std::pmr::vector<T>;
+// 函数体等较长的文本，随所在节点的分配器分配
+using ModelString = std::pmr::string;
+
+// 单文件模型内存池：模型节点从单调缓冲区分配，文件生成结束后一次性释放
+class CppModelArena {
+public:
+    explicit CppModelArena(size_t initial_size = 64 * 1024) : resource_(initial_size) {}
+
+    ModelAllocator GetAllocator() { return ModelAllocator(&resource_); }
+    void Release() { resource_.release(); }
+
+private:
+    std::pmr::monotonic_buffer_resource resource_;
+};
+#else
+// 不支持std::pmr时的占位分配器，模型节点使用默认堆分配
+struct ModelAllocator {};
+template<typename T>
+using ModelVector = std::vector<T>;
+using ModelString = std::string;
+
+class CppModelArena {
+public:
+    explicit CppModelArena(size_t initial_size = 0) {}
+
+    ModelAllocator GetAllocator() { return ModelAllocator(); }
+    void Release() {}
+};
+#endif
+
 // C++代码生成配置
 struct CppGeneratorOptions {
     Formatter::IndentStyle indent_style = Formatter::IndentStyle::SPACES_2;
@@ -20,14 +65,25 @@ struct CppGeneratorOptions {
     std::string include_guard_prefix;
 };
 
-// C++类型信息
+// 访问权限
+enum class AccessSpecifier { PUBLIC = 0, PROTECTED = 1, PRIVATE = 2 };
+const int kAccessSpecifierCount = 3;
+
+// 解析"public"/"protected"/"private"，无法识别时返回fallback
+AccessSpecifier ParseAccessSpecifier(const std::string& text, AccessSpecifier fallback);
+const char* AccessSpecifierName(AccessSpecifier access);
+
+// C++类型信息，类型名驻留在生成器的SymbolTable中
 struct CppType {
-    std::string name;
+    Symbol name;
     bool is_const = false;
     bool is_reference = false;
     bool is_pointer = false;
     
     std::string ToString() const;
+    // 直接追加到目标，不产生中间字符串
+    void AppendTo(std::string* out) const;
+    void AppendTo(Formatter& formatter) const;
 };
 
 // 函数参数
@@ -37,21 +93,48 @@ struct CppParameter {
     std::string default_value;
     
     std::string ToString() const;
+    void AppendTo(std::string* out) const;
+    void AppendTo(Formatter& formatter) const;
 };
 
 // 函数信息
 struct CppFunction {
-    std::string return_type;
+#ifdef CODE_GENERATOR_HAS_PMR
+    using allocator_type = ModelAllocator;
+#endif
+
+    CppFunction() = default;
+    explicit CppFunction(const ModelAllocator& alloc);
+    CppFunction(const CppFunction& other, const ModelAllocator& alloc);
+    CppFunction(CppFunction&& other, const ModelAllocator& alloc);
+    CppFunction(const CppFunction&) = default;
+    CppFunction(CppFunction&&) = default;
+    CppFunction& operator=(const CppFunction&) = default;
+    CppFunction& operator=(CppFunction&&) = default;
+
+    Symbol return_type;
     std::string name;
-    std::vector<CppParameter> parameters;
+    ModelVector<CppParameter> parameters;
     bool is_virtual = false;
     bool is_pure_virtual = false;
     bool is_const = false;
     bool is_static = false;
-    std::string body;
-    std::string access_specifier = "public";
+    ModelString body;
+    AccessSpecifier access_specifier = AccessSpecifier::PUBLIC;
+    
+    // 原地构造参数，返回新参数的引用
+    CppParameter& AddParameter(Symbol type_name, std::string param_name,
+                               std::string default_value = "");
     
     std::string GetSignature() const;
+    // 类外定义用签名：去掉virtual/static/= 0和默认参数，并加上类作用域
+    std::string GetDefinitionSignature(const std::string& class_name = "") const;
+    
+    // GetSignature/GetDefinitionSignature的直写版本
+    void AppendTo(std::string* out) const;
+    void AppendTo(Formatter& formatter) const;
+    void AppendDefinitionTo(std::string* out, const std::string& class_name = "") const;
+    void AppendDefinitionTo(Formatter& formatter, const std::string& class_name = "") const;
 };
 
 // 类成员变量
@@ -59,21 +142,52 @@ struct CppMember {
     CppType type;
     std::string name;
     std::string initializer;
-    std::string access_specifier = "private";
+    AccessSpecifier access_specifier = AccessSpecifier::PRIVATE;
     
     std::string ToString() const;
+    void AppendTo(std::string* out) const;
+    void AppendTo(Formatter& formatter) const;
 };
 
 // 类信息
 struct CppClass {
+#ifdef CODE_GENERATOR_HAS_PMR
+    using allocator_type = ModelAllocator;
+#endif
+
+    CppClass() = default;
+    explicit CppClass(const ModelAllocator& alloc);
+    CppClass(const CppClass& other, const ModelAllocator& alloc);
+    CppClass(CppClass&& other, const ModelAllocator& alloc);
+    CppClass(const CppClass&) = default;
+    CppClass(CppClass&&) = default;
+    CppClass& operator=(const CppClass&) = default;
+    CppClass& operator=(CppClass&&) = default;
+
+    // 名字、成员初始值和默认参数通常不超过短字符串优化的长度，仍用std::string
     std::string name;
-    std::vector<std::string> base_classes;
-    std::vector<CppMember> members;
-    std::vector<CppFunction> functions;
-    std::vector<std::string> forward_declarations;
+    ModelVector<ModelString> base_classes;
+    ModelVector<CppMember> members;
+    ModelVector<CppFunction> functions;
+    ModelVector<ModelString> forward_declarations;
     
     void AddFunction(const CppFunction& func);
+    void AddFunction(CppFunction&& func);
     void AddMember(const CppMember& member);
+    void AddMember(CppMember&& member);
+    
+    // 在容器内原地构造节点（使用类的分配器），返回新节点的引用
+    template<typename... Args>
+    CppFunction& EmplaceFunction(Args&&... args) {
+        functions.emplace_back(std::forward<Args>(args)...);
+        return functions.back();
+    }
+    
+    template<typename... Args>
+    CppMember& EmplaceMember(Args&&... args) {
+        members.emplace_back(std::forward<Args>(args)...);
+        return members.back();
+    }
 };
 
 // C++代码生成器
@@ -81,11 +195,19 @@ class CppGenerator {
 public:
     explicit CppGenerator(ZeroCopyOutputStreamPtr output, 
                          const CppGeneratorOptions& options = CppGeneratorOptions());
+    // 双输出模式：一次遍历模型，声明写入头文件流，定义写入源文件流
+    CppGenerator(ZeroCopyOutputStreamPtr header_output,
+                 ZeroCopyOutputStreamPtr source_output,
+                 const CppGeneratorOptions& options = CppGeneratorOptions());
     
     // 文件控制
     void BeginFile(const std::string& filename, const std::vector<std::string>& includes = {});
+    void BeginDualFile(const std::string& header_filename, const std::string& source_filename,
+                       const std::vector<std::string>& includes = {});
     void EndFile();
     
+    bool IsDualOutput() const { return source_formatter_ != nullptr; }
+    
     // 命名空间
     void BeginNamespace(const std::string& name);
     void EndNamespace();
@@ -113,15 +235,32 @@ public:
     void GenerateFunctionComment(const CppFunction& func);
     void GenerateMemberComment(const CppMember& member);
     
+    // 全局变量：双输出模式下头文件写extern声明，源文件写定义
+    void GenerateGlobal(const CppMember& global);
+    
     Formatter& GetFormatter() { return formatter_; }
+    // 本文件模型中的类型名，模型须在生成器销毁前用完
+    SymbolTable& GetSymbols() { return symbols_; }
+    // 单输出模式下返回头文件格式化器
+    Formatter& GetSourceFormatter() { return source_formatter_ ? *source_formatter_ : formatter_; }
 
 private:
+    struct ClassLayout;
+    
     Formatter formatter_;
+    std::unique_ptr<Formatter> source_formatter_;
     CppGeneratorOptions options_;
     std::string current_filename_;
+    SymbolTable symbols_;
     
+    void GenerateClassDual(const CppClass& cls);
+    void WriteClassDeclaration(const CppClass& cls, const ClassLayout& layout);
+    void WriteFunctionImplementation(Formatter& formatter, const CppFunction& func,
+                                     const std::string& class_name, bool has_declaration);
+    void WriteFileHeader(Formatter& formatter, const std::string& filename);
     void GenerateIncludeGuards(bool begin);
     void GenerateIncludes(const std::vector<std::string>& includes);
+    void GenerateIncludes(Formatter& formatter, const std::vector<std::string>& includes);
     std::string BuildIncludeGuard(const std::string& filename);
 };
 
@@ -3,6 +3,11 @@
 
 #include "cpp_generator.h"
 #include "config_parser.h"
+#include "config_validator.h"
+#include "thread_pool.h"
+#include "code_library_cache.h"
+#include "include_expander.h"
+#include "build_manifest.h"
 #include <filesystem>
 #include <unordered_set>
 
@@ -16,16 +21,26 @@ public:
     bool GenerateFromConfig(const code_generator::CodeGenConfig::ProjectConfig& config);
     bool GenerateFromConfigFile(const std::string& config_file);
     
+    // 生成前的完整校验：在配置检查之外还检查引用的模板和代码库组件，各文件并行检查，
+    // 所有问题一次追加到diagnostics，有错误时返回false。GenerateFromConfig在写入任何文件之前调用
+    bool ValidateConfig(const code_generator::CodeGenConfig::ProjectConfig& config,
+                        std::vector<ConfigDiagnostic>* diagnostics);
+    // 只加载并校验配置，不生成文件，问题输出到错误输出
+    bool ValidateConfigFile(const std::string& config_file);
+    
     // 单个文件生成
     bool GenerateFile(const code_generator::CodeGenConfig::FileConfig& file_config);
     
     // 代码模板处理
+    // 注意：模板、代码库和配置解析器在生成期间会被多个线程并发读取，
+    // RegisterTemplate/AddCodeLibrary/SetConfigParser须在GenerateFromConfig之前调用
     void RegisterTemplate(const std::string& name, const std::string& content);
     std::string ApplyTemplate(const std::string& template_name, 
                             const std::map<std::string, std::string>& variables = {});
     
     // 文件操作
     bool CopyFile(const std::string& source, const std::string& destination);
+    // 向已存在的文件末尾追加代码片段；生成流程中的片段由insert_snippets配置在渲染时写入
     bool InsertSnippet(const std::string& file_path, const std::string& snippet);
     bool EnsureDirectory(const std::string& path);
     
@@ -34,27 +49,114 @@ public:
     std::string ResolveCodeReference(const std::string& reference);
     
     // 设置配置解析器
-    void SetConfigParser(std::shared_ptr<code_generator::ConfigParser> parser) { config_parser_ = parser; }
+    void SetConfigParser(std::shared_ptr<code_generator::ConfigParser> parser) {
+        config_parser_ = parser;
+        include_expander_->ClearCache();
+    }
+    
+    // 每个文件的代码模型（容器、函数体和基类名）在单调内存池中分配，文件生成后一次性释放；
+    // 需要C++17的std::pmr，否则不起作用。命令行选项--model-arena
+    void SetUseModelArena(bool enable) { use_model_arena_ = enable; }
+    
+    // 并行生成的任务数（含调用线程），1为串行，0为硬件并发数
+    void SetJobs(size_t jobs);
+    // 与其他生成器共享同一线程池
+    void SetThreadPool(std::shared_ptr<ThreadPool> pool) { thread_pool_ = pool; }
+    // 代码库文件缓存，默认每个生成器独立一份；多个生成器可共享同一缓存
+    void SetCodeLibraryCache(std::shared_ptr<CodeLibraryCache> cache) { library_cache_ = cache; }
+    // 增量生成：输出目录中记录每个文件的输入指纹，指纹未变化的文件不再生成
+    void SetIncremental(bool enable) { incremental_ = enable; }
+    // 仅在内容变化时写入文件：整个文件先渲染到内存再与磁盘内容比较
+    // 默认关闭，生成内容直接流式写入磁盘
+    void SetWriteIfChanged(bool enable) { write_if_changed_ = enable; }
+    // 流式生成：GenerateFromConfigFile边解析边生成，files中的文件按批交给线程池，
+    // 内存中只保留当前批次；没有线程池时逐个生成，遇到失败即停止解析
+    void SetStreaming(bool enable) { streaming_ = enable; }
+    // GenerateFromConfigFile使用的编译后配置缓存目录，为空时不使用缓存；流式生成不经过缓存
+    void SetConfigCacheDirectory(const std::string& directory) { config_cache_dir_ = directory; }
+    // 错误输出目标，默认std::cerr
+    void SetErrorStream(std::ostream* stream) { error_stream_ = stream; }
 
 private:
+    static const int kOutputBufferSize = 64 * 1024;
+    // 流式生成时每批的文件数
+    static const size_t kStreamBatchFiles = 256;
+    
+    struct StreamBatch;
+    
     std::string output_dir_;
+    bool use_model_arena_;
+    bool incremental_;
+    bool write_if_changed_;
+    bool streaming_;
+    std::string config_cache_dir_;
     std::shared_ptr<code_generator::ConfigParser> config_parser_;
-    std::map<std::string, std::string> custom_templates_;
-    std::map<std::string, std::string> code_libraries_;
+    FlatStringMap<CompiledTemplate> custom_templates_;
+    StringMap code_libraries_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+    std::shared_ptr<CodeLibraryCache> library_cache_;
+    std::ostream* error_stream_;
+    std::unique_ptr<IncludeExpander> include_expander_;
     
-    // 生成具体内容
-    bool GenerateClass(const code_generator::CodeGenConfig::ClassConfig& class_config, code_generator::Formatter& formatter);
-    bool GenerateFunction(const code_generator::CodeGenConfig::FunctionConfig& func_config, code_generator::Formatter& formatter, bool in_class = false);
-    bool GenerateMember(const code_generator::CodeGenConfig::MemberConfig& member_config, code_generator::Formatter& formatter);
+    // 生成具体内容，失败原因写入error，由调用方按文件顺序输出
+    bool GenerateFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error);
+    // 增量模式下先比较指纹，未变化时直接返回成功
+    bool GenerateFileIncremental(const code_generator::CodeGenConfig::ProjectConfig& config,
+                                 const code_generator::CodeGenConfig::FileConfig& file_config,
+                                 const BuildManifest& manifest, std::string* fingerprint, std::string* error);
+    bool GenerateFromConfigStream(const std::string& config_file);
+    // 批次只会被执行一次：线程池尚未开始执行时由等待方直接执行
+    void RunStreamBatch(StreamBatch* batch, const code_generator::CodeGenConfig::ProjectConfig& config,
+                        const BuildManifest& manifest);
+    void WaitStreamBatch(StreamBatch* batch, const code_generator::CodeGenConfig::ProjectConfig& config,
+                         const BuildManifest& manifest);
+    bool GenerateSingleFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error);
+    bool GenerateDualFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error);
+    // 打开生成文件的输出流：流式模式直接写文件，仅写入变化模式写入buffer
+    code_generator::ZeroCopyOutputStreamPtr OpenOutput(const std::string& path, std::string* buffer, std::string* error);
+    // 流式模式刷新文件，仅写入变化模式比较后落盘
+    bool CloseOutput(code_generator::ZeroCopyOutputStreamPtr output, const std::string& path,
+                     const std::string& buffer, std::string* error);
+    // 单个文件的复制
+    void ProcessCopyFiles(const code_generator::CodeGenConfig::FileConfig& file_config);
+    // 在生成过程中写入指定位置的代码片段，文件只写一次
+    void WriteSnippets(const code_generator::CodeGenConfig::FileConfig& file_config,
+                       const std::string& anchor, CppGenerator& generator);
+    // 文件配置及其引用的模板、代码库、变量和生成器版本的指纹
+    std::string ComputeFingerprint(const code_generator::CodeGenConfig::ProjectConfig& config,
+                                   const code_generator::CodeGenConfig::FileConfig& file_config);
+    bool OutputsExist(const code_generator::CodeGenConfig::FileConfig& file_config) const;
+    // 直接写入文件的生成器，沿用它的选项，不经过中间字符串
+    bool GenerateClass(const code_generator::CodeGenConfig::ClassConfig& class_config, CppGenerator& generator,
+                       const ModelAllocator& alloc = ModelAllocator());
+    bool GenerateFunction(const code_generator::CodeGenConfig::FunctionConfig& func_config, CppGenerator& generator, bool in_class = false,
+                          const ModelAllocator& alloc = ModelAllocator());
+    bool GenerateMember(const code_generator::CodeGenConfig::MemberConfig& member_config, CppGenerator& generator);
     bool GenerateGlobal(const code_generator::CodeGenConfig::MemberConfig& global_config, code_generator::Formatter& formatter);
     
-    // 工具方法
-    CppClass ConvertToCppClass(const code_generator::CodeGenConfig::ClassConfig& config);
-    CppFunction ConvertToCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config);
-    CppMember ConvertToCppMember(const code_generator::CodeGenConfig::MemberConfig& config);
+    // 工具方法：类型名驻留到symbols中，模型在symbols存在期间有效
+    CppClass ConvertToCppClass(const code_generator::CodeGenConfig::ClassConfig& config, SymbolTable& symbols,
+                               const ModelAllocator& alloc = ModelAllocator());
+    CppFunction ConvertToCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config, SymbolTable& symbols,
+                                     const ModelAllocator& alloc = ModelAllocator());
+    CppMember ConvertToCppMember(const code_generator::CodeGenConfig::MemberConfig& config, SymbolTable& symbols);
+    // 原地填充已构造好的模型节点，避免临时对象拷贝
+    void BuildCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config, SymbolTable& symbols,
+                          CppFunction* function);
+    void BuildCppMember(const code_generator::CodeGenConfig::MemberConfig& config, SymbolTable& symbols,
+                        CppMember* member);
+    std::vector<std::string> CollectIncludes(const code_generator::CodeGenConfig::FileConfig& file_config) const;
+    std::string GetSourceFilename(const code_generator::CodeGenConfig::FileConfig& file_config) const;
+    // 解析引用但不拷贝：代码库文件直接指向内存映射，模板展开结果由holder持有
+    IncludeExpander::Resolved ResolveCodeReferenceText(const std::string& reference);
+    // 模板名或library::component引用能否解析，与ResolveCodeReference的查找顺序一致，只检查文件是否存在
+    bool CheckCodeReference(const std::string& reference, std::string* reason) const;
+    // 检查是否有多个文件写入同一路径
+    bool HasConflictingOutputs(const std::vector<code_generator::CodeGenConfig::FileConfig>& files) const;
     
-    std::string ProcessCodeBody(const std::string& body);
-    std::string ResolveKeywords(const std::string& text);
+    // source_name用于错误定位；@include循环或嵌套过深时抛出std::runtime_error
+    std::string ProcessCodeBody(const std::string& body, const std::string& source_name);
+    std::string ResolveKeywords(const std::string& text, const std::string& source_name);
 };
 
 }
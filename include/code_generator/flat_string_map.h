@@ -0,0 +1,162 @@
+#ifndef CODE_GENERATOR_FLAT_STRING_MAP_H
+#define CODE_GENERATOR_FLAT_STRING_MAP_H
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace code_generator {
+
+// 以字符串为键的开放寻址哈希表：键值对按插入顺序连续存放，另有一个线性探测的槽位数组
+// 保存哈希值和下标。查找接受string_view，不需要构造临时std::string
+// 接口与std::map的常用部分一致，遍历顺序为插入顺序；插入可能使已有的迭代器和引用失效，不支持删除
+template <typename V>
+class FlatStringMap {
+public:
+	typedef std::pair<std::string, V> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	FlatStringMap() {}
+
+	template <typename InputIt>
+	FlatStringMap(InputIt first, InputIt last) {
+		for (; first != last; ++first) {
+			(*this)[first->first] = first->second;
+		}
+	}
+
+	iterator begin() { return entries_.begin(); }
+	iterator end() { return entries_.end(); }
+	const_iterator begin() const { return entries_.begin(); }
+	const_iterator end() const { return entries_.end(); }
+
+	size_t size() const { return entries_.size(); }
+	bool empty() const { return entries_.empty(); }
+
+	void clear() {
+		entries_.clear();
+		slots_.clear();
+	}
+
+	void reserve(size_t count) {
+		entries_.reserve(count);
+		if (SlotCountFor(count) > slots_.size()) {
+			Rehash(SlotCountFor(count));
+		}
+	}
+
+	iterator find(boost::string_view key) {
+		size_t slot = FindSlot(key, Hash(key));
+		return slots_.empty() || slots_[slot].index == 0 ? end() : begin() + (slots_[slot].index - 1);
+	}
+
+	const_iterator find(boost::string_view key) const {
+		size_t slot = FindSlot(key, Hash(key));
+		return slots_.empty() || slots_[slot].index == 0 ? end() : begin() + (slots_[slot].index - 1);
+	}
+
+	size_t count(boost::string_view key) const { return find(key) != end() ? 1 : 0; }
+
+	V& at(boost::string_view key) {
+		iterator it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("FlatStringMap::at: key not found: " + key.to_string());
+		}
+		return it->second;
+	}
+
+	const V& at(boost::string_view key) const {
+		const_iterator it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("FlatStringMap::at: key not found: " + key.to_string());
+		}
+		return it->second;
+	}
+
+	V& operator[](boost::string_view key) { return emplace(key).first->second; }
+
+	// 键已存在时不修改，返回已有的项
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(boost::string_view key, Args&&... args) {
+		if ((entries_.size() + 1) * 4 > slots_.size() * 3) {
+			Rehash(SlotCountFor(entries_.size() + 1));
+		}
+
+		size_t hash = Hash(key);
+		size_t slot = FindSlot(key, hash);
+		if (slots_[slot].index != 0) {
+			return std::make_pair(begin() + (slots_[slot].index - 1), false);
+		}
+
+		entries_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key.data(), key.size()),
+							  std::forward_as_tuple(std::forward<Args>(args)...));
+		slots_[slot].hash = static_cast<uint32_t>(hash);
+		slots_[slot].index = static_cast<uint32_t>(entries_.size());
+		return std::make_pair(end() - 1, true);
+	}
+
+private:
+	// index为entries_中的下标加1，0表示空槽
+	struct Slot {
+		uint32_t hash = 0;
+		uint32_t index = 0;
+	};
+
+	std::vector<value_type> entries_;
+	// 大小为2的幂，负载不超过3/4
+	std::vector<Slot> slots_;
+
+	static size_t Hash(boost::string_view key) { return boost::hash_range(key.begin(), key.end()); }
+
+	static size_t SlotCountFor(size_t count) {
+		size_t slots = 8;
+		while (slots * 3 < count * 4) {
+			slots *= 2;
+		}
+		return slots;
+	}
+
+	// 返回键所在的槽位，不存在时返回探测到的第一个空槽；先比较哈希值再比较键
+	size_t FindSlot(boost::string_view key, size_t hash) const {
+		if (slots_.empty()) {
+			return 0;
+		}
+		size_t mask = slots_.size() - 1;
+		uint32_t tag = static_cast<uint32_t>(hash);
+		for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+			const Slot& current = slots_[slot];
+			if (current.index == 0 ||
+					(current.hash == tag && boost::string_view(entries_[current.index - 1].first) == key)) {
+				return slot;
+			}
+		}
+	}
+
+	void Rehash(size_t slot_count) {
+		std::vector<Slot> slots(slot_count);
+		size_t mask = slot_count - 1;
+		for (size_t i = 0; i < entries_.size(); ++i) {
+			size_t hash = Hash(entries_[i].first);
+			size_t slot = hash & mask;
+			while (slots[slot].index != 0) {
+				slot = (slot + 1) & mask;
+			}
+			slots[slot].hash = static_cast<uint32_t>(hash);
+			slots[slot].index = static_cast<uint32_t>(i + 1);
+		}
+		slots_.swap(slots);
+	}
+};
+
+// 变量、模板等字符串注册表
+typedef FlatStringMap<std::string> StringMap;
+
+} // namespace code_generator
+
+#endif
@@ -23,8 +23,12 @@ public:
 	// 基础输出
 	Formatter& Print(const std::string& text);
 	Formatter& Print(const char* text);
+	Formatter& Print(const char* data, size_t size);
 	Formatter& Print(int value);
 	Formatter& Print(const std::vector<std::string>& lines);
+	// 原样写入，不加缩进（用于插入外部代码片段）
+	Formatter& Raw(const std::string& text);
+	Formatter& Raw(const char* data, size_t size);
 
 	// Boost格式化
 	template<typename... Args>
@@ -0,0 +1,57 @@
+#ifndef CODE_GENERATOR_IMPORT_CACHE_H
+#define CODE_GENERATOR_IMPORT_CACHE_H
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/json.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace code_generator {
+
+// 被导入的配置文档，解析后只读，可被多个线程同时读取
+struct ImportedDocument {
+	// value在storage上构造，解析结果直接分配在其中，随文档一起释放
+	explicit ImportedDocument(boost::json::storage_ptr storage) : value(std::move(storage)) {}
+
+	std::string path;
+	// 文件内容的指纹，用于编译后配置缓存的依赖检查
+	uint64_t fingerprint = 0;
+	boost::json::value value;
+};
+
+// 进程内共享的导入文档缓存：同一文件只解析一次，多配置运行时所有配置共用
+// 文件的修改时间或大小变化后重新解析，正在使用的旧文档由shared_ptr保持有效
+class ImportCache : private boost::noncopyable {
+public:
+	typedef std::shared_ptr<const ImportedDocument> Document;
+
+	static ImportCache& Instance();
+
+	// path须为规范化的绝对路径；读取或解析失败时返回空指针并设置error
+	Document Get(const std::string& path, std::string* error);
+
+	size_t Size() const;
+	void Clear();
+
+private:
+	struct Entry {
+		int64_t mtime = 0;
+		uint64_t size = 0;
+		std::once_flag once;
+		Document document;
+		std::string error;
+	};
+
+	mutable std::mutex mutex_;
+	std::map<std::string, std::shared_ptr<Entry>> entries_;
+
+	static void Parse(const std::string& path, Entry* entry);
+};
+
+} // namespace code_generator
+
+#endif
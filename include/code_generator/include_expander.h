@@ -0,0 +1,62 @@
+#ifndef CODE_GENERATOR_INCLUDE_EXPANDER_H
+#define CODE_GENERATOR_INCLUDE_EXPANDER_H
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace code_generator {
+
+// @include(reference)展开器
+// 单遍扫描输入并写入输出缓冲区，被引用内容中的@include递归展开；
+// 完整展开后的引用结果会被缓存，可被多个线程同时使用
+class IncludeExpander : private boost::noncopyable {
+public:
+	// 引用的原文：text在holder存在期间有效，代码库文件可直接指向内存映射而不拷贝
+	struct Resolved {
+		std::shared_ptr<const void> holder;
+		boost::string_view text;
+	};
+
+	// 解析引用，返回空文本表示无法解析（展开为空，与旧行为一致）
+	typedef std::function<Resolved(const std::string& reference)> Resolver;
+
+	static const int kDefaultMaxDepth = 16;
+
+	explicit IncludeExpander(Resolver resolver, int max_depth = kDefaultMaxDepth);
+
+	// 展开text并追加到output；出现循环引用或超过嵌套深度时返回false，
+	// error中给出"来源:行:列"形式的位置和引用链
+	bool Expand(const std::string& text, const std::string& source_name,
+				std::string* output, std::string* error);
+
+	// 展开单个引用，被引用内容中的@include递归展开，结果与Expand中该引用处写入的内容相同；
+	// 用于按完整展开后的内容计算增量生成的指纹
+	bool ExpandReference(const std::string& reference, std::string* output, std::string* error);
+
+	// 模板或代码库变化后需要清空缓存
+	void ClearCache();
+
+private:
+	typedef std::shared_ptr<const std::string> Expanded;
+
+	Resolver resolver_;
+	int max_depth_;
+	std::mutex mutex_;
+	std::unordered_map<std::string, Expanded> cache_;
+
+	bool ExpandText(const char* data, size_t size, const std::string& source_name,
+					std::vector<std::string>* chain, std::string* output, std::string* error);
+	Expanded ExpandReference(const std::string& reference, std::vector<std::string>* chain,
+							 std::string* error);
+	static std::string FormatChain(const std::vector<std::string>& chain, const std::string& last);
+};
+
+} // namespace code_generator
+
+#endif
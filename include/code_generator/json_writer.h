@@ -0,0 +1,80 @@
+#ifndef CODE_GENERATOR_JSON_WRITER_H
+#define CODE_GENERATOR_JSON_WRITER_H
+
+#include "zero_copy_stream.h"
+#include <boost/json.hpp>
+#include <boost/utility/string_view.hpp>
+#include <string>
+#include <vector>
+
+namespace code_generator {
+
+// 流式JSON输出：按调用顺序把记号直接写入ZeroCopyOutputStream的缓冲窗口，
+// 不构造json::value树，也不经过中间字符串
+// 调用方负责记号的嵌套顺序，对象中每个值之前先调用Key
+// pretty为true时每个成员单独一行，按indent个空格缩进，空数组和空对象写为[]和{}
+class JsonWriter {
+public:
+	explicit JsonWriter(ZeroCopyOutputStream* output, bool pretty = false, int indent = 4);
+	~JsonWriter();
+
+	void BeginObject();
+	void EndObject();
+	void BeginArray();
+	void EndArray();
+
+	void Key(const char* data, size_t size);
+	void Key(boost::string_view key) { Key(key.data(), key.size()); }
+
+	void String(const char* data, size_t size);
+	void String(boost::string_view value) { String(value.data(), value.size()); }
+	void Bool(bool value);
+	void Null();
+	// 任意JSON值，用于保留原样的结构化内容
+	void Value(const boost::json::value& value);
+
+	void StringArray(const std::vector<std::string>& values);
+	// 键值都为字符串的映射，std::map和StringMap均可
+	template <typename Map>
+	void StringObject(const Map& map) {
+		BeginObject();
+		for (const auto& iter : map) {
+			Key(iter.first);
+			String(iter.second);
+		}
+		EndObject();
+	}
+
+	// 把未用完的缓冲窗口还给输出流；析构时自动调用
+	bool Flush();
+	// 输出流写入失败后不再写入
+	bool HasError() const { return error_; }
+
+private:
+	struct Level {
+		bool empty;
+	};
+
+	ZeroCopyOutputStream* output_;
+	bool pretty_;
+	int indent_;
+	std::vector<Level> levels_;
+	// 刚写完键，下一个值跟在冒号之后
+	bool after_key_ = false;
+	char* buffer_ = nullptr;
+	int available_ = 0;
+	bool error_ = false;
+
+	void BeforeValue();
+	void NewLine();
+	void Open(char token);
+	void Close(char token);
+	void WriteEscaped(const char* data, size_t size);
+	void Write(const char* data, size_t size);
+	void Put(char c);
+	bool NextBuffer();
+};
+
+} // namespace code_generator
+
+#endif
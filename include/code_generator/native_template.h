@@ -0,0 +1,123 @@
+#ifndef CODE_GENERATOR_NATIVE_TEMPLATE_H
+#define CODE_GENERATOR_NATIVE_TEMPLATE_H
+
+#include "formatter.h"
+#include "template_engine.h"
+#include <boost/filesystem.hpp>
+#include <boost/utility/string_view.hpp>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace code_generator {
+
+// 预先生成的原生渲染函数：变量按tables顺序查找，行为与CompiledTemplate::Render一致
+typedef void (*NativeTemplateRenderer)(std::initializer_list<const VariableTable*> tables, std::string* output);
+
+// 生成代码中的模板表项，source_hash为模板原文的指纹
+struct NativeTemplateEntry {
+	const char* name;
+	const char* source_hash;
+	NativeTemplateRenderer renderer;
+};
+
+#ifdef _WIN32
+#define CODE_GENERATOR_NATIVE_EXPORT __declspec(dllexport)
+#else
+#define CODE_GENERATOR_NATIVE_EXPORT __attribute__((visibility("default")))
+#endif
+
+// 插件导出的入口函数名，签名为 const NativeTemplateEntry* (*)(size_t* count)
+#define CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL "code_generator_native_templates"
+
+// 原生模板注册表：编译进程序的模板在静态初始化时注册，插件在运行时加载
+class NativeTemplateRegistry {
+public:
+	static NativeTemplateRegistry& Instance();
+
+	void Register(const NativeTemplateEntry& entry);
+	void Register(const NativeTemplateEntry* entries, size_t count);
+
+	// 模板原文与生成时不同（配置已修改）时返回nullptr，调用方回退到CompiledTemplate
+	NativeTemplateRenderer Find(const std::string& name, const std::string& source_text) const;
+
+	// 加载由--compile-templates生成并编译的动态库，库在进程结束前不会卸载
+	bool LoadPlugin(const boost::filesystem::path& path, std::string* error);
+
+	size_t Size() const;
+
+	static std::string SourceHash(const std::string& source_text);
+
+private:
+	struct Registration {
+		std::string source_hash;
+		NativeTemplateRenderer renderer;
+	};
+
+	mutable std::mutex mutex_;
+	std::map<std::string, Registration> templates_;
+	std::vector<std::shared_ptr<void>> plugins_;
+};
+
+// 编译进程序时用于静态注册
+class NativeTemplateRegistrar {
+public:
+	NativeTemplateRegistrar(const NativeTemplateEntry* entries, size_t count) {
+		NativeTemplateRegistry::Instance().Register(entries, count);
+	}
+};
+
+// 生成代码使用：依次在tables中查找变量，未定义时返回占位符本身
+boost::string_view NativeTemplateLookup(std::initializer_list<const VariableTable*> tables,
+										boost::string_view name, boost::string_view placeholder);
+
+// 把code_templates中的模板转换为C++源码：每个模板一个变量结构体和一个渲染函数，
+// 字面量段直接写成常量，渲染时不做解析和查找
+class NativeTemplateCompiler {
+public:
+	// 含{{#each}}/{{#if}}段落或编译失败的模板不生成原生代码，返回false并给出原因
+	bool AddTemplate(const std::string& name, const std::string& text, std::string* reason);
+
+	size_t Size() const { return templates_.size(); }
+
+	// 在output_dir下生成<basename>.h和<basename>.cpp
+	bool WriteFiles(const boost::filesystem::path& output_dir, const std::string& basename,
+					std::string* error) const;
+
+private:
+	struct Variable {
+		std::string name;	// 模板中的变量名
+		std::string member;	// 结构体成员名
+	};
+
+	struct Segment {
+		bool is_variable;
+		std::string text;	// 字面量内容
+		size_t variable;	// variables中的下标
+	};
+
+	struct Template {
+		std::string name;
+		std::string identifier;
+		std::string source_hash;
+		std::vector<Variable> variables;
+		std::vector<Segment> segments;
+		size_t literal_size;
+	};
+
+	std::vector<Template> templates_;
+
+	void WriteHeader(Formatter& formatter, const std::string& guard) const;
+	void WriteSource(Formatter& formatter, const std::string& header_name) const;
+	void WriteRenderer(Formatter& formatter, const Template& tmpl) const;
+
+	static std::string ToIdentifier(const std::string& name, bool camel_case);
+	static std::string QuoteLiteral(const std::string& text);
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef CODE_GENERATOR_PROJECT_SCHEDULER_H
+#define CODE_GENERATOR_PROJECT_SCHEDULER_H
+
+#include "code_library_cache.h"
+#include "thread_pool.h"
+#include <boost/core/noncopyable.hpp>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace code_generator {
+
+class ConfigParser;
+
+// 多配置调度器：所有项目共享一个线程池和代码库缓存并发生成
+// 项目内的文件级并行任务与项目级任务在同一线程池中调度
+// 输出目录相同的项目按添加顺序串行执行；非流式模式下与之前项目生成同一文件的项目直接失败
+class ProjectScheduler : private boost::noncopyable {
+public:
+	struct ProjectResult {
+		std::string config_file;
+		bool success = false;
+		double elapsed_ms = 0;
+		// 生成过程中的错误输出，按项目汇总后统一打印，避免多项目输出交错
+		std::string messages;
+	};
+
+	// jobs为1时串行执行，0为硬件并发数
+	explicit ProjectScheduler(size_t jobs = 1);
+
+	void AddConfig(const std::string& config_file);
+	void SetIncremental(bool enable) { incremental_ = enable; }
+	void SetWriteIfChanged(bool enable) { write_if_changed_ = enable; }
+	void SetStreaming(bool enable) { streaming_ = enable; }
+	void SetConfigCacheDirectory(const std::string& directory) { config_cache_dir_ = directory; }
+	// 每个文件的代码模型在各自的内存池中构建，见EnhancedCppGenerator::SetUseModelArena
+	void SetUseModelArena(bool enable) { use_model_arena_ = enable; }
+	// 只加载并校验各配置，不生成文件，每个项目的全部问题汇总在messages中
+	void SetValidateOnly(bool enable) { validate_only_ = enable; }
+
+	// 生成所有项目，全部成功返回true
+	bool Run();
+
+	const std::vector<ProjectResult>& GetResults() const { return results_; }
+
+	// 按添加顺序输出每个项目的结果和总体统计
+	void PrintResults(std::ostream& out) const;
+	void PrintSummary(std::ostream& out) const;
+
+	std::shared_ptr<CodeLibraryCache> GetCodeLibraryCache() const { return library_cache_; }
+
+private:
+	std::vector<std::string> config_files_;
+	std::vector<ProjectResult> results_;
+	std::shared_ptr<ThreadPool> thread_pool_;
+	std::shared_ptr<CodeLibraryCache> library_cache_;
+	double total_elapsed_ms_;
+	bool incremental_;
+	bool write_if_changed_;
+	bool streaming_;
+	bool validate_only_;
+	bool use_model_arena_;
+	std::string config_cache_dir_;
+	// 分组时加载的配置，生成时直接使用，不重复解析；流式模式下为空
+	std::vector<std::shared_ptr<ConfigParser>> parsers_;
+
+	// 按规范化的输出目录分组，rejected标记输出文件与组内之前的项目冲突的项目
+	void GroupByOutputDirectory(std::vector<std::vector<size_t>>* groups, std::vector<char>* rejected);
+	// 读取项目的输出目录；流式模式下只解析files之前的项目设置
+	std::string LoadOutputDirectory(size_t index);
+	void RunProject(size_t index);
+};
+
+} // namespace code_generator
+
+#endif
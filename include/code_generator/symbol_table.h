@@ -0,0 +1,56 @@
+#ifndef CODE_GENERATOR_SYMBOL_TABLE_H
+#define CODE_GENERATOR_SYMBOL_TABLE_H
+
+#include <boost/core/noncopyable.hpp>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+
+namespace code_generator {
+
+class SymbolTable;
+
+// 驻留字符串句柄，指向所属SymbolTable中的字符串，比较只比较指针
+// 只在所属的表存在期间有效
+class Symbol {
+public:
+	Symbol() : text_(&EmptyString()) {}
+	explicit Symbol(SymbolTable& table, const std::string& text);
+
+	const std::string& str() const { return *text_; }
+	bool empty() const { return text_->empty(); }
+
+	bool operator==(const Symbol& other) const { return text_ == other.text_; }
+	bool operator!=(const Symbol& other) const { return text_ != other.text_; }
+
+private:
+	friend class SymbolTable;
+	explicit Symbol(const std::string* text) : text_(text) {}
+
+	static const std::string& EmptyString();
+
+	const std::string* text_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Symbol& symbol) {
+	return os << symbol.str();
+}
+
+// 类型名驻留表：同一文件中反复出现的类型名（int、const std::string&、返回类型等）只保存一份
+// 表由CppGenerator持有，文件生成结束后随生成器释放；函数名、成员名等标识符不驻留
+// 并行构建模型时可以同时驻留
+class SymbolTable : private boost::noncopyable {
+public:
+	Symbol Intern(const std::string& text);
+	size_t Size() const;
+
+private:
+	mutable std::mutex mutex_;
+	// unordered_set的节点地址稳定，Symbol直接指向其中的字符串
+	std::unordered_set<std::string> strings_;
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef CODE_GENERATOR_TEMPLATE_ENGINE_H
+#define CODE_GENERATOR_TEMPLATE_ENGINE_H
+
+#include "flat_string_map.h"
+#include <boost/json.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace code_generator {
+
+// 模板变量表：按string_view哈希查找，查找时不构造临时字符串
+class VariableTable {
+public:
+	VariableTable() {}
+	explicit VariableTable(const std::map<std::string, std::string>& variables);
+	explicit VariableTable(const StringMap& variables) : values_(variables) {}
+
+	void Assign(const std::map<std::string, std::string>& variables);
+	void Assign(const StringMap& variables) { values_ = variables; }
+	void Set(const std::string& name, const std::string& value) { values_[name] = value; }
+
+	// 未定义时返回nullptr
+	const std::string* Find(boost::string_view name) const {
+		auto it = values_.find(name);
+		return it != values_.end() ? &it->second : nullptr;
+	}
+
+	size_t Size() const { return values_.size(); }
+
+private:
+	StringMap values_;
+};
+
+// 预编译模板：文本在编译时转换为字节码，展开时顺序执行，不做查找替换
+// 支持的语法：
+//   ${NAME}                      变量
+//   {{#each NAME}}...{{/each}}   遍历数组，循环体内${字段}先在当前元素中查找，
+//                                ${this}为当前元素本身，${@index}为下标
+//   {{#if NAME}}...{{else}}...{{/if}}
+//                                条件，NAME可以是变量、结构化数据或@first/@last
+// 不认识的{{...}}按字面量输出（C++代码中常见的"{{"不受影响）
+class CompiledTemplate {
+public:
+	CompiledTemplate() : literal_size_(0), has_sections_(false) {}
+	explicit CompiledTemplate(std::string text);
+
+	const std::string& Text() const { return text_; }
+	bool Empty() const { return text_.empty(); }
+	bool HasVariables() const;
+
+	// 段落标记不匹配时编译失败，此时{{...}}按原文输出，只替换${NAME}
+	bool Ok() const { return error_.empty(); }
+	const std::string& GetError() const { return error_; }
+
+	// 变量按tables顺序查找，先找到的生效；data为结构化变量（数组/对象），
+	// each/if优先在其中查找。未定义的占位符原样保留，变量值中的${...}不会再被展开
+	void Render(std::initializer_list<const VariableTable*> tables, std::string* output,
+				const boost::json::object* data = nullptr) const;
+	std::string Render(std::initializer_list<const VariableTable*> tables,
+					   const boost::json::object* data = nullptr) const;
+
+	// 不预编译，直接单遍展开任意文本中的${NAME}
+	static void RenderText(boost::string_view text, std::initializer_list<const VariableTable*> tables,
+						   std::string* output);
+
+private:
+	// 读取字节码生成原生渲染函数
+	friend class NativeTemplateCompiler;
+	// 字节码写入配置缓存，命中时直接恢复，不重新编译
+	friend class ConfigCache;
+
+	enum class OpCode : uint8_t {
+		LITERAL,	// 输出text_[offset, offset + length)
+		VARIABLE,	// 输出名称为text_[offset, offset + length)的变量
+		EACH,		// 开始遍历，数组为空时跳到target
+		NEXT,		// 下一个元素，未结束时跳回target
+		IF,			// 条件为假时跳到target
+		JUMP		// 无条件跳到target
+	};
+
+	struct Instruction {
+		OpCode op;
+		uint32_t offset;
+		uint32_t length;
+		uint32_t target;
+	};
+
+	std::string text_;
+	std::vector<Instruction> program_;
+	size_t literal_size_;
+	bool has_sections_;
+	std::string error_;
+
+	void Compile(bool sections_enabled);
+	void EmitLiteral(size_t begin, size_t end);
+	void Emit(OpCode op, size_t offset, size_t length, size_t target = 0);
+	// 识别{{...}}段落标记并生成指令，不是段落标记时返回false
+	bool CompileTag(size_t tag_begin, size_t tag_end, size_t* literal_begin, std::vector<size_t>* sections);
+	void Execute(std::initializer_list<const VariableTable*> tables, const boost::json::object* data,
+				 std::string* output) const;
+
+	static const std::string* Lookup(boost::string_view name, std::initializer_list<const VariableTable*> tables);
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CODE_GENERATOR_THREAD_POOL_H
+#define CODE_GENERATOR_THREAD_POOL_H
+
+#include <boost/core/noncopyable.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace code_generator {
+
+// 工作窃取线程池
+// 每个工作线程有自己的任务队列，从队尾取任务；本地队列为空时从其他线程队首窃取。
+// ParallelFor的调用线程也会参与执行任务，因此可以在池内任务中嵌套调用而不会死锁。
+class ThreadPool : private boost::noncopyable {
+public:
+	// thread_count为0时使用硬件并发数
+	explicit ThreadPool(size_t thread_count = 0);
+	~ThreadPool();
+
+	size_t Size() const { return workers_.size(); }
+
+	// 提交任务，任务内的异常会被吞掉，需要结果时请使用ParallelFor
+	void Submit(std::function<void()> task);
+
+	// 并行执行fn(0) ... fn(count - 1)，全部完成后返回；
+	// 任一任务抛出异常时，等待其余任务结束后重新抛出第一个异常
+	void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+	// 根据-j参数换算工作线程数：调用线程也参与执行，因此比jobs少一个
+	static size_t WorkersForJobs(size_t jobs);
+
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues_;
+	std::vector<std::thread> workers_;
+	std::mutex wake_mutex_;
+	std::condition_variable wake_cv_;
+	std::atomic<size_t> pending_;
+	std::atomic<size_t> next_queue_;
+	bool stop_;
+
+	void WorkerLoop(size_t index);
+	bool TryRunOne(size_t preferred);
+	size_t CurrentQueue();
+};
+
+} // namespace code_generator
+
+#endif
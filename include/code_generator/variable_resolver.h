@@ -0,0 +1,77 @@
+#ifndef CODE_GENERATOR_VARIABLE_RESOLVER_H
+#define CODE_GENERATOR_VARIABLE_RESOLVER_H
+
+#include "flat_string_map.h"
+#include "template_engine.h"
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace code_generator {
+
+// 变量解析器：变量的值可以引用其他变量，也可以由函数计算（如TIMESTAMP）
+// 变量之间的引用构成依赖图，按需深度优先求值：只有被用到的变量才会展开，
+// 每个变量只展开一次并缓存结果，结果与定义顺序无关
+// 支持间接引用：${A_${B}}先展开内层得到名称，再查找该名称的变量
+// 循环引用时相关占位符原样保留，并记录错误
+// 求值会修改缓存，不能被多个线程同时使用
+class VariableResolver {
+public:
+	typedef std::function<std::string()> Provider;
+
+	VariableResolver() {}
+	explicit VariableResolver(const StringMap& variables);
+
+	// 同名变量后定义的覆盖先定义的，已缓存的结果全部失效
+	void Define(boost::string_view name, const std::string& raw_value);
+	// 计算变量在第一次被用到时调用provider
+	void DefineComputed(boost::string_view name, Provider provider);
+
+	// 展开后的值，未定义或处于循环引用中时返回nullptr
+	const std::string* Resolve(boost::string_view name);
+
+	// 展开text中的占位符，未定义的占位符原样保留
+	void Expand(boost::string_view text, std::string* output);
+
+	// 展开所有变量，用于渲染时按表查找
+	void ResolveAll(StringMap* values);
+
+	bool HasError() const { return !error_.empty(); }
+	// 第一次检测到的循环，如"A -> B -> A"
+	const std::string& GetError() const { return error_; }
+
+	// 按已展开的变量表展开text，同样支持间接引用，不做递归求值
+	static void ExpandText(boost::string_view text, const VariableTable& table, std::string* output);
+
+private:
+	enum class State : uint8_t {
+		PENDING,
+		RESOLVING,
+		DONE
+	};
+
+	struct Variable {
+		std::string raw;
+		Provider provider;
+		// 原始值中没有占位符时直接使用raw，不复制
+		std::string value;
+		bool expanded = false;
+		State state = State::PENDING;
+
+		const std::string& Result() const { return expanded ? value : raw; }
+	};
+
+	FlatStringMap<Variable> variables_;
+	bool has_results_ = false;
+	// 当前求值路径，用于报告循环
+	std::vector<std::string> resolving_;
+	std::string error_;
+
+	void ResetStates();
+};
+
+} // namespace code_generator
+
+#endif
@@ -0,0 +1,864 @@
+#include "code_generator/binary_config.h"
+#include "code_generator/code_library_cache.h"
+#include "code_generator/file_streams.h"
+#include "code_generator/json_writer.h"
+#include "code_generator/stream_adapters.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace code_generator {
+
+namespace {
+
+// 限制嵌套深度，防止恶意输入耗尽栈
+const int kMaxDepth = 64;
+
+// CBOR自描述标签55799的编码
+const unsigned char kCborSelfDescribe[3] = { 0xd9, 0xd9, 0xf7 };
+
+// 顺序读取大端编码的数据，越界时返回false
+class ByteReader {
+public:
+	ByteReader(const char* data, size_t size) : data_(reinterpret_cast<const unsigned char*>(data)), size_(size) {}
+
+	size_t Offset() const { return offset_; }
+	size_t Remaining() const { return size_ - offset_; }
+
+	bool ReadByte(uint8_t* value) {
+		if (offset_ >= size_) {
+			return false;
+		}
+		*value = data_[offset_++];
+		return true;
+	}
+
+	bool Peek(uint8_t* value) const {
+		if (offset_ >= size_) {
+			return false;
+		}
+		*value = data_[offset_];
+		return true;
+	}
+
+	bool ReadBigEndian(size_t bytes, uint64_t* value) {
+		if (Remaining() < bytes) {
+			return false;
+		}
+		uint64_t result = 0;
+		for (size_t i = 0; i < bytes; ++i) {
+			result = (result << 8) | data_[offset_ + i];
+		}
+		offset_ += bytes;
+		*value = result;
+		return true;
+	}
+
+	bool ReadBytes(uint64_t length, const char** data) {
+		if (Remaining() < length) {
+			return false;
+		}
+		*data = reinterpret_cast<const char*>(data_ + offset_);
+		offset_ += static_cast<size_t>(length);
+		return true;
+	}
+
+private:
+	const unsigned char* data_;
+	size_t size_;
+	size_t offset_ = 0;
+};
+
+double BitsToFloat(uint64_t bits) {
+	uint32_t value = static_cast<uint32_t>(bits);
+	float result;
+	memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+double BitsToDouble(uint64_t bits) {
+	double result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+// IEEE 754半精度
+double HalfToDouble(uint64_t bits) {
+	int exponent = static_cast<int>((bits >> 10) & 0x1f);
+	double mantissa = static_cast<double>(bits & 0x3ff);
+	double result;
+	if (exponent == 0) {
+		result = std::ldexp(mantissa, -24);
+	} else if (exponent == 31) {
+		result = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+	} else {
+		result = std::ldexp(mantissa + 1024, exponent - 25);
+	}
+	return (bits & 0x8000) ? -result : result;
+}
+
+class CborDecoder {
+public:
+	CborDecoder(const char* data, size_t size) : reader_(data, size) {}
+
+	bool Decode(json::value* value, std::string* error) {
+		if (!DecodeValue(value, 0) || (reader_.Remaining() > 0 && Fail("unexpected data after the document"))) {
+			*error = "CBOR decoding error at offset " + std::to_string(reader_.Offset()) + ": " + error_;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	static const uint8_t kIndefinite = 31;
+	static const uint8_t kBreak = 0xff;
+
+	ByteReader reader_;
+	std::string error_;
+	// 不定长文本分段拼接的缓冲区
+	std::string scratch_;
+
+	bool Fail(const char* reason) {
+		error_ = reason;
+		return false;
+	}
+
+	// 读取初始字节和紧随其后的参数，不定长时info为31
+	bool ReadHead(uint8_t* major, uint8_t* info, uint64_t* argument) {
+		uint8_t initial;
+		if (!reader_.ReadByte(&initial)) {
+			return Fail("unexpected end of data");
+		}
+		*major = initial >> 5;
+		*info = initial & 0x1f;
+		*argument = *info;
+		if (*info < 24 || *info == kIndefinite) {
+			return true;
+		}
+		if (*info > 27) {
+			return Fail("reserved additional information");
+		}
+		if (!reader_.ReadBigEndian(static_cast<size_t>(1) << (*info - 24), argument)) {
+			return Fail("unexpected end of data");
+		}
+		return true;
+	}
+
+	// 定长文本直接指向输入，不定长文本拼接到scratch_
+	bool ReadText(uint8_t info, uint64_t length, const char** data, size_t* size) {
+		if (info != kIndefinite) {
+			if (!reader_.ReadBytes(length, data)) {
+				return Fail("unexpected end of data");
+			}
+			*size = static_cast<size_t>(length);
+			return true;
+		}
+
+		scratch_.clear();
+		for (;;) {
+			uint8_t major, chunk_info;
+			uint64_t chunk_length;
+			if (!ReadHead(&major, &chunk_info, &chunk_length)) {
+				return false;
+			}
+			if (major == 7 && chunk_info == kIndefinite) {
+				break;
+			}
+			const char* chunk;
+			if (major != 3 || chunk_info == kIndefinite) {
+				return Fail("invalid chunk in indefinite-length text");
+			}
+			if (!reader_.ReadBytes(chunk_length, &chunk)) {
+				return Fail("unexpected end of data");
+			}
+			scratch_.append(chunk, static_cast<size_t>(chunk_length));
+		}
+		*data = scratch_.data();
+		*size = scratch_.size();
+		return true;
+	}
+
+	// 不定长容器以break字节结束
+	bool AtBreak(bool indefinite, uint64_t index, uint64_t count) {
+		if (!indefinite) {
+			return index >= count;
+		}
+		uint8_t next;
+		if (!reader_.Peek(&next) || next != kBreak) {
+			return false;
+		}
+		reader_.ReadByte(&next);
+		return true;
+	}
+
+	bool DecodeValue(json::value* value, int depth) {
+		if (depth > kMaxDepth) {
+			return Fail("nesting too deep");
+		}
+
+		uint8_t major, info;
+		uint64_t argument;
+		if (!ReadHead(&major, &info, &argument)) {
+			return false;
+		}
+		if (info == kIndefinite && (major == 0 || major == 1 || major == 6)) {
+			return Fail("invalid indefinite length");
+		}
+
+		switch (major) {
+		case 0:
+			if (argument <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+				value->emplace_int64() = static_cast<int64_t>(argument);
+			} else {
+				value->emplace_uint64() = argument;
+			}
+			return true;
+		case 1:
+			// 值为-1-argument，超出int64范围时退化为double
+			if (argument <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+				value->emplace_int64() = -1 - static_cast<int64_t>(argument);
+			} else {
+				value->emplace_double() = -1.0 - static_cast<double>(argument);
+			}
+			return true;
+		case 2:
+			return Fail("byte strings are not supported");
+		case 3: {
+			const char* data;
+			size_t size;
+			if (!ReadText(info, argument, &data, &size)) {
+				return false;
+			}
+			value->emplace_string().assign(data, size);
+			return true;
+		}
+		case 4: {
+			bool indefinite = info == kIndefinite;
+			// 每个元素至少占一个字节，按剩余长度限制预分配
+			if (!indefinite && argument > reader_.Remaining()) {
+				return Fail("array length exceeds the data");
+			}
+			json::array& array = value->emplace_array();
+			if (!indefinite) {
+				array.reserve(static_cast<size_t>(argument));
+			}
+			for (uint64_t i = 0; !AtBreak(indefinite, i, argument); ++i) {
+				array.emplace_back(nullptr);
+				if (!DecodeValue(&array.back(), depth + 1)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case 5: {
+			bool indefinite = info == kIndefinite;
+			if (!indefinite && argument > reader_.Remaining() / 2) {
+				return Fail("map length exceeds the data");
+			}
+			json::object& object = value->emplace_object();
+			if (!indefinite) {
+				object.reserve(static_cast<size_t>(argument));
+			}
+			for (uint64_t i = 0; !AtBreak(indefinite, i, argument); ++i) {
+				uint8_t key_major, key_info;
+				uint64_t key_length;
+				if (!ReadHead(&key_major, &key_info, &key_length)) {
+					return false;
+				}
+				if (key_major != 3) {
+					return Fail("map keys must be text strings");
+				}
+				const char* key;
+				size_t key_size;
+				if (!ReadText(key_info, key_length, &key, &key_size)) {
+					return false;
+				}
+				// 同名键以后出现的为准，与json::parse一致
+				json::value& member = object[json::string_view(key, key_size)];
+				if (!DecodeValue(&member, depth + 1)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case 6:
+			// 标签（如自描述标签）只起标注作用，直接解码被标注的值
+			return DecodeValue(value, depth + 1);
+		default:
+			break;
+		}
+
+		switch (info) {
+		case 20:
+			value->emplace_bool() = false;
+			return true;
+		case 21:
+			value->emplace_bool() = true;
+			return true;
+		case 22:
+		case 23:
+			value->emplace_null();
+			return true;
+		case 25:
+			value->emplace_double() = HalfToDouble(argument);
+			return true;
+		case 26:
+			value->emplace_double() = BitsToFloat(argument);
+			return true;
+		case 27:
+			value->emplace_double() = BitsToDouble(argument);
+			return true;
+		case kIndefinite:
+			return Fail("unexpected break");
+		default:
+			return Fail("unsupported simple value");
+		}
+	}
+};
+
+class MessagePackDecoder {
+public:
+	MessagePackDecoder(const char* data, size_t size) : reader_(data, size) {}
+
+	bool Decode(json::value* value, std::string* error) {
+		if (!DecodeValue(value, 0) || (reader_.Remaining() > 0 && Fail("unexpected data after the document"))) {
+			*error = "MessagePack decoding error at offset " + std::to_string(reader_.Offset()) + ": " + error_;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	ByteReader reader_;
+	std::string error_;
+
+	bool Fail(const char* reason) {
+		error_ = reason;
+		return false;
+	}
+
+	bool ReadLength(size_t bytes, uint64_t* length) {
+		return reader_.ReadBigEndian(bytes, length) || Fail("unexpected end of data");
+	}
+
+	bool ReadString(uint64_t length, json::string* text) {
+		const char* data;
+		if (!reader_.ReadBytes(length, &data)) {
+			return Fail("unexpected end of data");
+		}
+		text->assign(data, static_cast<size_t>(length));
+		return true;
+	}
+
+	// 读取键的类型字节和长度，键必须是字符串
+	bool ReadKey(const char** data, size_t* size) {
+		uint8_t type;
+		uint64_t length;
+		if (!reader_.ReadByte(&type)) {
+			return Fail("unexpected end of data");
+		}
+		if (type >= 0xa0 && type <= 0xbf) {
+			length = type & 0x1f;
+		} else if (type >= 0xd9 && type <= 0xdb) {
+			if (!ReadLength(static_cast<size_t>(1) << (type - 0xd9), &length)) {
+				return false;
+			}
+		} else {
+			return Fail("map keys must be strings");
+		}
+		if (!reader_.ReadBytes(length, data)) {
+			return Fail("unexpected end of data");
+		}
+		*size = static_cast<size_t>(length);
+		return true;
+	}
+
+	bool DecodeArray(uint64_t count, json::value* value, int depth) {
+		if (count > reader_.Remaining()) {
+			return Fail("array length exceeds the data");
+		}
+		json::array& array = value->emplace_array();
+		array.reserve(static_cast<size_t>(count));
+		for (uint64_t i = 0; i < count; ++i) {
+			array.emplace_back(nullptr);
+			if (!DecodeValue(&array.back(), depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool DecodeMap(uint64_t count, json::value* value, int depth) {
+		if (count > reader_.Remaining() / 2) {
+			return Fail("map length exceeds the data");
+		}
+		json::object& object = value->emplace_object();
+		object.reserve(static_cast<size_t>(count));
+		for (uint64_t i = 0; i < count; ++i) {
+			const char* key;
+			size_t key_size;
+			if (!ReadKey(&key, &key_size)) {
+				return false;
+			}
+			json::value& member = object[json::string_view(key, key_size)];
+			if (!DecodeValue(&member, depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool DecodeValue(json::value* value, int depth) {
+		if (depth > kMaxDepth) {
+			return Fail("nesting too deep");
+		}
+
+		uint8_t type;
+		if (!reader_.ReadByte(&type)) {
+			return Fail("unexpected end of data");
+		}
+
+		// 单字节编码的小整数、短字符串和小容器
+		if (type <= 0x7f) {
+			value->emplace_int64() = type;
+			return true;
+		}
+		if (type >= 0xe0) {
+			value->emplace_int64() = static_cast<int8_t>(type);
+			return true;
+		}
+		if (type <= 0x8f) {
+			return DecodeMap(type & 0x0f, value, depth);
+		}
+		if (type <= 0x9f) {
+			return DecodeArray(type & 0x0f, value, depth);
+		}
+		if (type <= 0xbf) {
+			return ReadString(type & 0x1f, &value->emplace_string());
+		}
+
+		uint64_t argument;
+		switch (type) {
+		case 0xc0:
+			value->emplace_null();
+			return true;
+		case 0xc2:
+			value->emplace_bool() = false;
+			return true;
+		case 0xc3:
+			value->emplace_bool() = true;
+			return true;
+		case 0xca:
+			if (!ReadLength(4, &argument)) {
+				return false;
+			}
+			value->emplace_double() = BitsToFloat(argument);
+			return true;
+		case 0xcb:
+			if (!ReadLength(8, &argument)) {
+				return false;
+			}
+			value->emplace_double() = BitsToDouble(argument);
+			return true;
+		case 0xcc:
+		case 0xcd:
+		case 0xce:
+		case 0xcf:
+			if (!ReadLength(static_cast<size_t>(1) << (type - 0xcc), &argument)) {
+				return false;
+			}
+			if (argument <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+				value->emplace_int64() = static_cast<int64_t>(argument);
+			} else {
+				value->emplace_uint64() = argument;
+			}
+			return true;
+		case 0xd0:
+			if (!ReadLength(1, &argument)) {
+				return false;
+			}
+			value->emplace_int64() = static_cast<int8_t>(argument);
+			return true;
+		case 0xd1:
+			if (!ReadLength(2, &argument)) {
+				return false;
+			}
+			value->emplace_int64() = static_cast<int16_t>(argument);
+			return true;
+		case 0xd2:
+			if (!ReadLength(4, &argument)) {
+				return false;
+			}
+			value->emplace_int64() = static_cast<int32_t>(argument);
+			return true;
+		case 0xd3:
+			if (!ReadLength(8, &argument)) {
+				return false;
+			}
+			value->emplace_int64() = static_cast<int64_t>(argument);
+			return true;
+		case 0xd9:
+		case 0xda:
+		case 0xdb:
+			if (!ReadLength(static_cast<size_t>(1) << (type - 0xd9), &argument)) {
+				return false;
+			}
+			return ReadString(argument, &value->emplace_string());
+		case 0xdc:
+		case 0xdd:
+			if (!ReadLength(type == 0xdc ? 2 : 4, &argument)) {
+				return false;
+			}
+			return DecodeArray(argument, value, depth);
+		case 0xde:
+		case 0xdf:
+			if (!ReadLength(type == 0xde ? 2 : 4, &argument)) {
+				return false;
+			}
+			return DecodeMap(argument, value, depth);
+		default:
+			// 0xc4-0xc9和0xd4-0xd8为二进制和扩展类型，0xc1未使用
+			return Fail("binary and extension types are not supported");
+		}
+	}
+};
+
+void AppendBigEndian(uint64_t value, size_t bytes, std::string* output) {
+	for (size_t i = bytes; i > 0; --i) {
+		output->push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xff));
+	}
+}
+
+void AppendDouble(uint8_t type, double value, std::string* output) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	output->push_back(static_cast<char>(type));
+	AppendBigEndian(bits, 8, output);
+}
+
+class CborEncoder {
+public:
+	explicit CborEncoder(std::string* output) : output_(output) {}
+
+	void Encode(const json::value& value) {
+		output_->append(reinterpret_cast<const char*>(kCborSelfDescribe), sizeof(kCborSelfDescribe));
+		EncodeValue(value);
+	}
+
+private:
+	std::string* output_;
+
+	void WriteHead(uint8_t major, uint64_t argument) {
+		uint8_t initial = static_cast<uint8_t>(major << 5);
+		if (argument < 24) {
+			output_->push_back(static_cast<char>(initial | argument));
+		} else if (argument <= 0xff) {
+			output_->push_back(static_cast<char>(initial | 24));
+			AppendBigEndian(argument, 1, output_);
+		} else if (argument <= 0xffff) {
+			output_->push_back(static_cast<char>(initial | 25));
+			AppendBigEndian(argument, 2, output_);
+		} else if (argument <= 0xffffffffu) {
+			output_->push_back(static_cast<char>(initial | 26));
+			AppendBigEndian(argument, 4, output_);
+		} else {
+			output_->push_back(static_cast<char>(initial | 27));
+			AppendBigEndian(argument, 8, output_);
+		}
+	}
+
+	void WriteText(const char* data, size_t size) {
+		WriteHead(3, size);
+		output_->append(data, size);
+	}
+
+	void EncodeValue(const json::value& value) {
+		switch (value.kind()) {
+		case json::kind::null:
+			output_->push_back(static_cast<char>(0xf6));
+			break;
+		case json::kind::bool_:
+			output_->push_back(static_cast<char>(value.get_bool() ? 0xf5 : 0xf4));
+			break;
+		case json::kind::int64:
+			if (value.get_int64() >= 0) {
+				WriteHead(0, static_cast<uint64_t>(value.get_int64()));
+			} else {
+				WriteHead(1, static_cast<uint64_t>(-1 - value.get_int64()));
+			}
+			break;
+		case json::kind::uint64:
+			WriteHead(0, value.get_uint64());
+			break;
+		case json::kind::double_:
+			AppendDouble(0xfb, value.get_double(), output_);
+			break;
+		case json::kind::string:
+			WriteText(value.get_string().data(), value.get_string().size());
+			break;
+		case json::kind::array:
+			WriteHead(4, value.get_array().size());
+			for (const auto& item : value.get_array()) {
+				EncodeValue(item);
+			}
+			break;
+		case json::kind::object:
+			WriteHead(5, value.get_object().size());
+			for (const auto& iter : value.get_object()) {
+				WriteText(iter.key().data(), iter.key().size());
+				EncodeValue(iter.value());
+			}
+			break;
+		}
+	}
+};
+
+class MessagePackEncoder {
+public:
+	explicit MessagePackEncoder(std::string* output) : output_(output) {}
+
+	void Encode(const json::value& value) {
+		switch (value.kind()) {
+		case json::kind::null:
+			output_->push_back(static_cast<char>(0xc0));
+			break;
+		case json::kind::bool_:
+			output_->push_back(static_cast<char>(value.get_bool() ? 0xc3 : 0xc2));
+			break;
+		case json::kind::int64:
+			WriteInteger(value.get_int64());
+			break;
+		case json::kind::uint64:
+			WriteUnsigned(value.get_uint64());
+			break;
+		case json::kind::double_:
+			AppendDouble(0xcb, value.get_double(), output_);
+			break;
+		case json::kind::string:
+			WriteString(value.get_string().data(), value.get_string().size());
+			break;
+		case json::kind::array:
+			WriteHead(0x90, 0xdc, value.get_array().size());
+			for (const auto& item : value.get_array()) {
+				Encode(item);
+			}
+			break;
+		case json::kind::object:
+			WriteHead(0x80, 0xde, value.get_object().size());
+			for (const auto& iter : value.get_object()) {
+				WriteString(iter.key().data(), iter.key().size());
+				Encode(iter.value());
+			}
+			break;
+		}
+	}
+
+private:
+	std::string* output_;
+
+	// 容器头：不超过15个元素时用单字节编码，否则用16位或32位长度（type16和type16 + 1）
+	void WriteHead(uint8_t fix_type, uint8_t type16, size_t count) {
+		if (count <= 15) {
+			output_->push_back(static_cast<char>(fix_type | count));
+		} else if (count <= 0xffff) {
+			output_->push_back(static_cast<char>(type16));
+			AppendBigEndian(count, 2, output_);
+		} else {
+			output_->push_back(static_cast<char>(type16 + 1));
+			AppendBigEndian(count, 4, output_);
+		}
+	}
+
+	void WriteString(const char* data, size_t size) {
+		if (size <= 31) {
+			output_->push_back(static_cast<char>(0xa0 | size));
+		} else if (size <= 0xff) {
+			output_->push_back(static_cast<char>(0xd9));
+			AppendBigEndian(size, 1, output_);
+		} else if (size <= 0xffff) {
+			output_->push_back(static_cast<char>(0xda));
+			AppendBigEndian(size, 2, output_);
+		} else {
+			output_->push_back(static_cast<char>(0xdb));
+			AppendBigEndian(size, 4, output_);
+		}
+		output_->append(data, size);
+	}
+
+	void WriteUnsigned(uint64_t value) {
+		if (value <= 0x7f) {
+			output_->push_back(static_cast<char>(value));
+		} else if (value <= 0xff) {
+			output_->push_back(static_cast<char>(0xcc));
+			AppendBigEndian(value, 1, output_);
+		} else if (value <= 0xffff) {
+			output_->push_back(static_cast<char>(0xcd));
+			AppendBigEndian(value, 2, output_);
+		} else if (value <= 0xffffffffu) {
+			output_->push_back(static_cast<char>(0xce));
+			AppendBigEndian(value, 4, output_);
+		} else {
+			output_->push_back(static_cast<char>(0xcf));
+			AppendBigEndian(value, 8, output_);
+		}
+	}
+
+	void WriteInteger(int64_t value) {
+		if (value >= 0) {
+			WriteUnsigned(static_cast<uint64_t>(value));
+		} else if (value >= -32) {
+			output_->push_back(static_cast<char>(value));
+		} else if (value >= std::numeric_limits<int8_t>::min()) {
+			output_->push_back(static_cast<char>(0xd0));
+			AppendBigEndian(static_cast<uint64_t>(value), 1, output_);
+		} else if (value >= std::numeric_limits<int16_t>::min()) {
+			output_->push_back(static_cast<char>(0xd1));
+			AppendBigEndian(static_cast<uint64_t>(value), 2, output_);
+		} else if (value >= std::numeric_limits<int32_t>::min()) {
+			output_->push_back(static_cast<char>(0xd2));
+			AppendBigEndian(static_cast<uint64_t>(value), 4, output_);
+		} else {
+			output_->push_back(static_cast<char>(0xd3));
+			AppendBigEndian(static_cast<uint64_t>(value), 8, output_);
+		}
+	}
+};
+
+} // namespace
+
+const char* ConfigFormatName(ConfigFormat format) {
+	switch (format) {
+	case ConfigFormat::CBOR:
+		return "CBOR";
+	case ConfigFormat::MESSAGE_PACK:
+		return "MessagePack";
+	default:
+		return "JSON";
+	}
+}
+
+ConfigFormat BinaryConfigCodec::Detect(const char* data, size_t size) {
+	if (size == 0) {
+		return ConfigFormat::JSON;
+	}
+	uint8_t first = static_cast<uint8_t>(data[0]);
+	if (size >= sizeof(kCborSelfDescribe) && memcmp(data, kCborSelfDescribe, sizeof(kCborSelfDescribe)) == 0) {
+		return ConfigFormat::CBOR;
+	}
+	if (first >= 0xa0 && first <= 0xbf) {
+		return ConfigFormat::CBOR;
+	}
+	if ((first >= 0x80 && first <= 0x8f) || first == 0xde || first == 0xdf) {
+		return ConfigFormat::MESSAGE_PACK;
+	}
+	return ConfigFormat::JSON;
+}
+
+bool BinaryConfigCodec::FormatFromExtension(const boost::filesystem::path& path, ConfigFormat* format) {
+	std::string extension = path.extension().string();
+	if (extension == ".json") {
+		*format = ConfigFormat::JSON;
+	} else if (extension == ".cbor") {
+		*format = ConfigFormat::CBOR;
+	} else if (extension == ".msgpack" || extension == ".mpk") {
+		*format = ConfigFormat::MESSAGE_PACK;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool BinaryConfigCodec::Decode(ConfigFormat format, const char* data, size_t size, json::value* value,
+							   std::string* error) {
+	if (format == ConfigFormat::CBOR) {
+		return CborDecoder(data, size).Decode(value, error);
+	}
+	if (format == ConfigFormat::MESSAGE_PACK) {
+		return MessagePackDecoder(data, size).Decode(value, error);
+	}
+	*error = "not a binary config format";
+	return false;
+}
+
+bool BinaryConfigCodec::Parse(const char* data, size_t size, json::value* value, std::string* error) {
+	ConfigFormat format = Detect(data, size);
+	if (format != ConfigFormat::JSON) {
+		return Decode(format, data, size, value, error);
+	}
+	try {
+		// 解析结果与value使用同一个storage，赋值时只移动不拷贝
+		*value = json::parse(json::string_view(data, size), value->storage());
+	} catch (const std::exception& e) {
+		*error = "JSON parsing error: " + std::string(e.what());
+		return false;
+	}
+	return true;
+}
+
+void BinaryConfigCodec::Encode(ConfigFormat format, const json::value& value, std::string* output) {
+	if (format == ConfigFormat::CBOR) {
+		CborEncoder(output).Encode(value);
+	} else if (format == ConfigFormat::MESSAGE_PACK) {
+		MessagePackEncoder(output).Encode(value);
+	} else {
+		StringOutputStream stream(output);
+		JsonWriter writer(&stream, true);
+		writer.Value(value);
+	}
+}
+
+bool BinaryConfigCodec::ConvertFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+									std::string* error) {
+	ConfigFormat output_format;
+	if (!FormatFromExtension(output, &output_format)) {
+		*error = "Unknown output format: " + output.string() + " (expected .json, .cbor or .msgpack)";
+		return false;
+	}
+
+	std::unique_ptr<MappedFile> mapped;
+	try {
+		mapped.reset(new MappedFile(input.string()));
+	} catch (const std::exception& e) {
+		*error = "Cannot read " + input.string() + ": " + e.what();
+		return false;
+	}
+	json::storage_ptr arena = json::make_shared_resource<json::monotonic_resource>(mapped->size() * 2 + 4096);
+	json::value document(arena);
+	if (!Parse(mapped->data(), mapped->size(), &document, error)) {
+		*error = input.string() + ": " + *error;
+		return false;
+	}
+
+	// 文件打不开时FileOutputStream的构造函数抛出异常
+	std::unique_ptr<FileOutputStream> output_stream;
+	try {
+		output_stream.reset(new FileOutputStream(output));
+	} catch (const std::exception& e) {
+		*error = "Cannot open " + output.string() + ": " + e.what();
+		return false;
+	}
+	FileOutputStream& stream = *output_stream;
+	if (output_format == ConfigFormat::JSON) {
+		JsonWriter writer(&stream, true);
+		writer.Value(document);
+		if (!writer.Flush() || !stream.WriteChar('\n')) {
+			*error = "Cannot write " + output.string();
+			return false;
+		}
+	} else {
+		std::string encoded;
+		Encode(output_format, document, &encoded);
+		if (!stream.WriteString(encoded)) {
+			*error = "Cannot write " + output.string();
+			return false;
+		}
+	}
+	if (!stream.Flush()) {
+		*error = "Cannot write " + output.string();
+		return false;
+	}
+	return true;
+}
+
+} // namespace code_generator
@@ -0,0 +1,96 @@
+#include "code_generator/build_manifest.h"
+#include "code_generator/version.h"
+#include <cstdio>
+#include <fstream>
+
+namespace code_generator {
+
+namespace {
+
+const char* kManifestHeader = "# codegen manifest v1 ";
+
+// 输出修订号：生成结果的格式或语义变化时递增，项目版本不变也能让旧清单和配置缓存失效
+#define CODE_GENERATOR_OUTPUT_REVISION "1"
+
+} // namespace
+
+const char* BuildManifest::kFileName = ".codegen_manifest";
+const char* BuildManifest::kGeneratorVersion = CPP_CODE_GENERATOR_VERSION "+r" CODE_GENERATOR_OUTPUT_REVISION;
+
+Fingerprint& Fingerprint::Update(const std::string& data) {
+	return Update(data.data(), data.size());
+}
+
+Fingerprint& Fingerprint::Update(const char* data, size_t size) {
+	Update(static_cast<uint64_t>(size));
+	for (size_t i = 0; i < size; ++i) {
+		hash_ ^= static_cast<unsigned char>(data[i]);
+		hash_ *= kPrime;
+	}
+	return *this;
+}
+
+Fingerprint& Fingerprint::Update(uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		hash_ ^= (value >> (i * 8)) & 0xff;
+		hash_ *= kPrime;
+	}
+	return *this;
+}
+
+std::string Fingerprint::ToHex() const {
+	char buffer[17];
+	std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash_));
+	return buffer;
+}
+
+bool BuildManifest::Load(const std::string& path) {
+	entries_.clear();
+
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	std::string line;
+	if (!std::getline(file, line) || line != std::string(kManifestHeader) + kGeneratorVersion) {
+		return false;
+	}
+
+	while (std::getline(file, line)) {
+		size_t pos = line.find(' ');
+		if (pos == std::string::npos || pos == 0 || pos + 1 >= line.size()) {
+			continue;
+		}
+		entries_[line.substr(pos + 1)] = line.substr(0, pos);
+	}
+	return true;
+}
+
+bool BuildManifest::Save(const std::string& path) const {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	file << kManifestHeader << kGeneratorVersion << "\n";
+	for (const auto& iter : entries_) {
+		file << iter.second << " " << iter.first << "\n";
+	}
+	return static_cast<bool>(file);
+}
+
+std::string BuildManifest::Get(const std::string& filename) const {
+	auto it = entries_.find(filename);
+	return it != entries_.end() ? it->second : std::string();
+}
+
+void BuildManifest::Set(const std::string& filename, const std::string& fingerprint) {
+	entries_[filename] = fingerprint;
+}
+
+void BuildManifest::Remove(const std::string& filename) {
+	entries_.erase(filename);
+}
+
+} // namespace code_generator
@@ -0,0 +1,154 @@
+#include "code_generator/code_library_cache.h"
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <exception>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace code_generator {
+
+MappedFile::MappedFile(const std::string& path) : data_(""), size_(0) {
+	// 空文件无法建立映射
+	if (boost::filesystem::file_size(path) == 0) {
+		return;
+	}
+
+	boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+	// 映射建立后file_mapping可以释放，映射区域仍然有效
+	boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+	region_.swap(region);
+	data_ = static_cast<const char*>(region_.get_address());
+	size_ = region_.get_size();
+}
+
+CodeLibraryCache::CodeLibraryCache(size_t byte_budget)
+		: byte_budget_(byte_budget), total_bytes_(0) {
+}
+
+CodeLibraryCache::Content CodeLibraryCache::Get(const std::string& path) {
+	FileStamp stamp;
+	if (!StatFile(path, &stamp)) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = entries_.find(path);
+		if (it != entries_.end()) {
+			EraseLocked(it);
+		}
+		return Content();
+	}
+
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = entries_.find(path);
+		if (it != entries_.end() && it->second->stamp != stamp) {
+			// 文件已被修改或替换，丢弃旧映射
+			EraseLocked(it);
+			it = entries_.end();
+		}
+		if (it == entries_.end()) {
+			entry = std::make_shared<Entry>();
+			entry->stamp = stamp;
+			lru_.push_front(path);
+			entry->lru_position = lru_.begin();
+			entries_[path] = entry;
+		} else {
+			entry = it->second;
+			lru_.splice(lru_.begin(), lru_, entry->lru_position);
+		}
+	}
+
+	// 在表锁之外映射文件，不同文件的映射互不阻塞
+	std::call_once(entry->once, [&entry, &path]() {
+		entry->content = MapFile(path);
+	});
+
+	if (entry->content && !entry->counted) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = entries_.find(path);
+		if (!entry->counted && it != entries_.end() && it->second == entry) {
+			entry->counted = true;
+			total_bytes_ += entry->content->size();
+			EvictLocked(path);
+		}
+	}
+	return entry->content;
+}
+
+void CodeLibraryCache::SetByteBudget(size_t byte_budget) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	byte_budget_ = byte_budget;
+	EvictLocked(std::string());
+}
+
+size_t CodeLibraryCache::Size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+size_t CodeLibraryCache::Bytes() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return total_bytes_;
+}
+
+void CodeLibraryCache::Clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+	lru_.clear();
+	total_bytes_ = 0;
+}
+
+bool CodeLibraryCache::StatFile(const std::string& path, FileStamp* stamp) {
+#ifndef _WIN32
+	struct stat st;
+	if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+		return false;
+	}
+	stamp->inode = static_cast<uint64_t>(st.st_ino);
+#if defined(__APPLE__)
+	stamp->mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	stamp->mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+	stamp->size = static_cast<uint64_t>(st.st_size);
+	return true;
+#else
+	boost::system::error_code ec;
+	if (!boost::filesystem::is_regular_file(path, ec)) {
+		return false;
+	}
+	stamp->mtime_ns = static_cast<int64_t>(boost::filesystem::last_write_time(path, ec)) * 1000000000;
+	stamp->size = static_cast<uint64_t>(boost::filesystem::file_size(path, ec));
+	return !ec;
+#endif
+}
+
+CodeLibraryCache::Content CodeLibraryCache::MapFile(const std::string& path) {
+	try {
+		return std::make_shared<const MappedFile>(path);
+	} catch (const std::exception& e) {
+		return Content();
+	}
+}
+
+void CodeLibraryCache::EraseLocked(std::map<std::string, std::shared_ptr<Entry>>::iterator it) {
+	if (it->second->counted) {
+		total_bytes_ -= it->second->content->size();
+	}
+	lru_.erase(it->second->lru_position);
+	entries_.erase(it);
+}
+
+void CodeLibraryCache::EvictLocked(const std::string& keep) {
+	// 从最久未使用的一端淘汰，刚访问的文件即使超出预算也保留
+	while (total_bytes_ > byte_budget_ && !lru_.empty()) {
+		const std::string& victim = lru_.back();
+		if (victim == keep) {
+			break;
+		}
+		EraseLocked(entries_.find(victim));
+	}
+}
+
+} // namespace code_generator
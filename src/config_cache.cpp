@@ -0,0 +1,478 @@
+#include "code_generator/config_cache.h"
+#include "code_generator/build_manifest.h"
+#include "code_generator/code_library_cache.h"
+#include <cstring>
+#include <fstream>
+
+namespace code_generator {
+
+namespace {
+
+const char kMagic[4] = {'C', 'G', 'C', 'C'};
+const char* kCacheExtension = ".cgcc";
+const size_t kHeaderSize = sizeof(kMagic) + sizeof(uint32_t) + sizeof(uint64_t) * 2;
+
+// 定长整数按本机字节序写入，字符串和数组前写入长度
+class BinaryWriter {
+public:
+	explicit BinaryWriter(std::string* buffer) : buffer_(buffer) {}
+
+	template <typename T>
+	void WritePod(T value) {
+		buffer_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	void WriteBool(bool value) { WritePod<uint8_t>(value ? 1 : 0); }
+	void WriteSize(size_t size) { WritePod<uint32_t>(static_cast<uint32_t>(size)); }
+
+	void WriteString(const std::string& str) {
+		WriteSize(str.size());
+		buffer_->append(str);
+	}
+
+	void WriteStrings(const std::vector<std::string>& strs) {
+		WriteSize(strs.size());
+		for (const auto& str : strs) {
+			WriteString(str);
+		}
+	}
+
+	template <typename Map>
+	void WriteStringMap(const Map& map) {
+		WriteSize(map.size());
+		for (const auto& iter : map) {
+			WriteString(iter.first);
+			WriteString(iter.second);
+		}
+	}
+
+private:
+	std::string* buffer_;
+};
+
+// 读取越界时返回false，不抛出异常
+class BinaryReader {
+public:
+	BinaryReader(const char* data, const char* end) : data_(data), end_(end) {}
+
+	const char* Position() const { return data_; }
+
+	template <typename T>
+	bool ReadPod(T* value) {
+		if (static_cast<size_t>(end_ - data_) < sizeof(T)) {
+			return false;
+		}
+		std::memcpy(value, data_, sizeof(T));
+		data_ += sizeof(T);
+		return true;
+	}
+
+	bool ReadBool(bool* value) {
+		uint8_t byte = 0;
+		if (!ReadPod(&byte)) {
+			return false;
+		}
+		*value = byte != 0;
+		return true;
+	}
+
+	bool ReadSize(size_t* size) {
+		uint32_t value = 0;
+		if (!ReadPod(&value)) {
+			return false;
+		}
+		*size = value;
+		return true;
+	}
+
+	bool ReadString(std::string* str) {
+		size_t size = 0;
+		if (!ReadSize(&size) || static_cast<size_t>(end_ - data_) < size) {
+			return false;
+		}
+		str->assign(data_, size);
+		data_ += size;
+		return true;
+	}
+
+	bool ReadStrings(std::vector<std::string>* strs) {
+		size_t count = 0;
+		if (!ReadCount(&count)) {
+			return false;
+		}
+		strs->resize(count);
+		for (auto& str : *strs) {
+			if (!ReadString(&str)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename Map>
+	bool ReadStringMap(Map* map) {
+		size_t count = 0;
+		if (!ReadCount(&count)) {
+			return false;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			std::string key;
+			std::string value;
+			if (!ReadString(&key) || !ReadString(&value)) {
+				return false;
+			}
+			(*map)[key] = std::move(value);
+		}
+		return true;
+	}
+
+	// 每个元素至少占4字节，数量超过剩余长度时视为损坏，避免按错误的数量预分配
+	bool ReadCount(size_t* count) {
+		return ReadSize(count) && *count <= static_cast<size_t>(end_ - data_) / sizeof(uint32_t);
+	}
+
+private:
+	const char* data_;
+	const char* end_;
+};
+
+void WriteFunction(BinaryWriter& writer, const CodeGenConfig::FunctionConfig& function) {
+	writer.WriteString(function.name);
+	writer.WriteString(function.return_type);
+	writer.WriteSize(function.parameters.size());
+	for (const auto& parameter : function.parameters) {
+		writer.WriteString(parameter.first);
+		writer.WriteString(parameter.second);
+	}
+	writer.WriteString(function.body);
+	writer.WriteString(function.access);
+	writer.WriteBool(function.is_virtual);
+	writer.WriteBool(function.is_pure_virtual);
+	writer.WriteBool(function.is_const);
+	writer.WriteBool(function.is_static);
+	writer.WriteStrings(function.templates);
+}
+
+bool ReadFunction(BinaryReader& reader, CodeGenConfig::FunctionConfig* function) {
+	size_t count = 0;
+	if (!reader.ReadString(&function->name) || !reader.ReadString(&function->return_type) ||
+			!reader.ReadCount(&count)) {
+		return false;
+	}
+	function->parameters.resize(count);
+	for (auto& parameter : function->parameters) {
+		if (!reader.ReadString(&parameter.first) || !reader.ReadString(&parameter.second)) {
+			return false;
+		}
+	}
+	return reader.ReadString(&function->body) && reader.ReadString(&function->access) &&
+		   reader.ReadBool(&function->is_virtual) && reader.ReadBool(&function->is_pure_virtual) &&
+		   reader.ReadBool(&function->is_const) && reader.ReadBool(&function->is_static) &&
+		   reader.ReadStrings(&function->templates);
+}
+
+void WriteMember(BinaryWriter& writer, const CodeGenConfig::MemberConfig& member) {
+	writer.WriteString(member.name);
+	writer.WriteString(member.type);
+	writer.WriteString(member.initializer);
+	writer.WriteString(member.access);
+	writer.WriteString(member.comment);
+}
+
+bool ReadMember(BinaryReader& reader, CodeGenConfig::MemberConfig* member) {
+	return reader.ReadString(&member->name) && reader.ReadString(&member->type) &&
+		   reader.ReadString(&member->initializer) && reader.ReadString(&member->access) &&
+		   reader.ReadString(&member->comment);
+}
+
+template <typename T, typename WriteFunc>
+void WriteVector(BinaryWriter& writer, const std::vector<T>& items, WriteFunc write) {
+	writer.WriteSize(items.size());
+	for (const auto& item : items) {
+		write(writer, item);
+	}
+}
+
+template <typename T, typename ReadFunc>
+bool ReadVector(BinaryReader& reader, std::vector<T>* items, ReadFunc read) {
+	size_t count = 0;
+	if (!reader.ReadCount(&count)) {
+		return false;
+	}
+	items->resize(count);
+	for (auto& item : *items) {
+		if (!read(reader, &item)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void WriteClass(BinaryWriter& writer, const CodeGenConfig::ClassConfig& cls) {
+	writer.WriteString(cls.name);
+	writer.WriteStrings(cls.base_classes);
+	writer.WriteStrings(cls.templates);
+	writer.WriteStringMap(cls.metadata);
+	WriteVector(writer, cls.functions, WriteFunction);
+	WriteVector(writer, cls.members, WriteMember);
+}
+
+bool ReadClass(BinaryReader& reader, CodeGenConfig::ClassConfig* cls) {
+	return reader.ReadString(&cls->name) && reader.ReadStrings(&cls->base_classes) &&
+		   reader.ReadStrings(&cls->templates) && reader.ReadStringMap(&cls->metadata) &&
+		   ReadVector(reader, &cls->functions, ReadFunction) && ReadVector(reader, &cls->members, ReadMember);
+}
+
+void WriteSnippet(BinaryWriter& writer, const CodeGenConfig::SnippetConfig& snippet) {
+	writer.WriteString(snippet.reference);
+	writer.WriteString(snippet.anchor);
+	writer.WriteString(snippet.target);
+}
+
+bool ReadSnippet(BinaryReader& reader, CodeGenConfig::SnippetConfig* snippet) {
+	return reader.ReadString(&snippet->reference) && reader.ReadString(&snippet->anchor) &&
+		   reader.ReadString(&snippet->target);
+}
+
+void WriteFile(BinaryWriter& writer, const CodeGenConfig::FileConfig& file) {
+	writer.WriteString(file.filename);
+	writer.WriteString(file.type);
+	writer.WriteString(file.source_filename);
+	writer.WriteStrings(file.includes);
+	writer.WriteStrings(file.namespaces);
+	WriteVector(writer, file.classes, WriteClass);
+	WriteVector(writer, file.functions, WriteFunction);
+	WriteVector(writer, file.globals, WriteMember);
+	writer.WriteStringMap(file.templates);
+	writer.WriteStrings(file.copy_files);
+	WriteVector(writer, file.insert_snippets, WriteSnippet);
+}
+
+bool ReadFile(BinaryReader& reader, CodeGenConfig::FileConfig* file) {
+	return reader.ReadString(&file->filename) && reader.ReadString(&file->type) &&
+		   reader.ReadString(&file->source_filename) && reader.ReadStrings(&file->includes) &&
+		   reader.ReadStrings(&file->namespaces) && ReadVector(reader, &file->classes, ReadClass) &&
+		   ReadVector(reader, &file->functions, ReadFunction) && ReadVector(reader, &file->globals, ReadMember) &&
+		   reader.ReadStringMap(&file->templates) && reader.ReadStrings(&file->copy_files) &&
+		   ReadVector(reader, &file->insert_snippets, ReadSnippet);
+}
+
+uint64_t FileFingerprint(const std::string& path) {
+	MappedFile mapped(path);
+	return Fingerprint().Update(mapped.data(), mapped.size()).Value();
+}
+
+} // namespace
+
+uint64_t ConfigCache::ComputeKey(const std::string& content) {
+	Fingerprint fingerprint;
+	fingerprint.Update(static_cast<uint64_t>(kFormatVersion));
+	fingerprint.Update(std::string(BuildManifest::kGeneratorVersion));
+	fingerprint.Update(content);
+	return fingerprint.Value();
+}
+
+boost::filesystem::path ConfigCache::CachePath(const boost::filesystem::path& config_file) const {
+	Fingerprint fingerprint;
+	fingerprint.Update(boost::filesystem::absolute(config_file).lexically_normal().string());
+	return directory_ / (fingerprint.ToHex() + kCacheExtension);
+}
+
+bool ConfigCache::Load(const boost::filesystem::path& config_file, uint64_t key,
+					   std::map<std::string, uint64_t>* imported_files, CodeGenConfig::ProjectConfig* config,
+					   FlatStringMap<CompiledTemplate>* templates) const {
+	boost::filesystem::path cache_path = CachePath(config_file);
+	boost::system::error_code ec;
+	if (!boost::filesystem::is_regular_file(cache_path, ec)) {
+		return false;
+	}
+
+	try {
+		MappedFile mapped(cache_path.string());
+		BinaryReader header(mapped.data(), mapped.data() + mapped.size());
+		char magic[sizeof(kMagic)];
+		uint32_t format_version = 0;
+		uint64_t stored_key = 0;
+		uint64_t payload_size = 0;
+		if (!header.ReadPod(&magic) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+				!header.ReadPod(&format_version) || format_version != kFormatVersion ||
+				!header.ReadPod(&stored_key) || stored_key != key || !header.ReadPod(&payload_size) ||
+				payload_size != mapped.size() - kHeaderSize) {
+			return false;
+		}
+
+		BinaryReader reader(header.Position(), mapped.data() + mapped.size());
+		std::map<std::string, uint64_t> dependencies;
+		size_t dependency_count = 0;
+		if (!reader.ReadCount(&dependency_count)) {
+			return false;
+		}
+		for (size_t i = 0; i < dependency_count; ++i) {
+			std::string path;
+			uint64_t fingerprint = 0;
+			if (!reader.ReadString(&path) || !reader.ReadPod(&fingerprint)) {
+				return false;
+			}
+			// 导入的文件不存在时MappedFile抛出异常，按未命中处理
+			if (FileFingerprint(path) != fingerprint) {
+				return false;
+			}
+			dependencies[path] = fingerprint;
+		}
+
+		CodeGenConfig::ProjectConfig loaded;
+		std::string structured_variables;
+		if (!reader.ReadString(&loaded.name) || !reader.ReadString(&loaded.version) ||
+				!reader.ReadString(&loaded.output_dir) || !reader.ReadStrings(&loaded.imports) || !ReadVector(reader, &loaded.files, ReadFile) ||
+				!reader.ReadStringMap(&loaded.variables) || !reader.ReadString(&structured_variables) ||
+				!reader.ReadStrings(&loaded.common_includes) || !reader.ReadStringMap(&loaded.code_templates)) {
+			return false;
+		}
+		// 结构化变量只在模板的each/if中使用，数量很少，以JSON文本保存
+		if (!structured_variables.empty()) {
+			json::value data = json::parse(structured_variables);
+			if (!data.is_object()) {
+				return false;
+			}
+			loaded.structured_variables = std::move(data.as_object());
+		}
+
+		FlatStringMap<CompiledTemplate> compiled;
+		size_t template_count = 0;
+		if (!reader.ReadCount(&template_count) || template_count != loaded.code_templates.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < template_count; ++i) {
+			std::string name;
+			if (!reader.ReadString(&name)) {
+				return false;
+			}
+			auto text = loaded.code_templates.find(name);
+			if (text == loaded.code_templates.end()) {
+				return false;
+			}
+			CompiledTemplate tmpl;
+			tmpl.text_ = text->second;
+			const char* data = reader.Position();
+			const char* end = mapped.data() + mapped.size();
+			if (!ReadProgram(&data, end, &tmpl)) {
+				return false;
+			}
+			reader = BinaryReader(data, end);
+			compiled.emplace(name, std::move(tmpl));
+		}
+
+		*imported_files = std::move(dependencies);
+		*config = std::move(loaded);
+		*templates = std::move(compiled);
+		return true;
+	} catch (const std::exception&) {
+		// 缓存文件损坏按未命中处理
+		return false;
+	}
+}
+
+bool ConfigCache::Store(const boost::filesystem::path& config_file, uint64_t key,
+						const std::map<std::string, uint64_t>& imported_files,
+						const CodeGenConfig::ProjectConfig& config,
+						const FlatStringMap<CompiledTemplate>& templates, std::string* error) const {
+	std::string payload;
+	BinaryWriter writer(&payload);
+	writer.WriteSize(imported_files.size());
+	for (const auto& iter : imported_files) {
+		writer.WriteString(iter.first);
+		writer.WritePod(iter.second);
+	}
+	writer.WriteString(config.name);
+	writer.WriteString(config.version);
+	writer.WriteString(config.output_dir);
+	writer.WriteStrings(config.imports);
+	WriteVector(writer, config.files, WriteFile);
+	writer.WriteStringMap(config.variables);
+	writer.WriteString(config.structured_variables.empty() ? std::string() : json::serialize(config.structured_variables));
+	writer.WriteStrings(config.common_includes);
+	writer.WriteStringMap(config.code_templates);
+	writer.WriteSize(templates.size());
+	for (const auto& iter : templates) {
+		writer.WriteString(iter.first);
+		WriteProgram(iter.second, &payload);
+	}
+
+	std::string header;
+	BinaryWriter header_writer(&header);
+	header.append(kMagic, sizeof(kMagic));
+	header_writer.WritePod(kFormatVersion);
+	header_writer.WritePod(key);
+	header_writer.WritePod(static_cast<uint64_t>(payload.size()));
+
+	boost::system::error_code ec;
+	boost::filesystem::create_directories(directory_, ec);
+	boost::filesystem::path cache_path = CachePath(config_file);
+	boost::filesystem::path temp_path = cache_path;
+	temp_path += boost::filesystem::unique_path(".%%%%-%%%%.tmp", ec);
+	{
+		std::ofstream file(temp_path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file) {
+			*error = "Cannot create config cache file: " + temp_path.string();
+			return false;
+		}
+		file.write(header.data(), header.size());
+		file.write(payload.data(), payload.size());
+		if (!file) {
+			file.close();
+			boost::filesystem::remove(temp_path, ec);
+			*error = "Cannot write config cache file: " + temp_path.string();
+			return false;
+		}
+	}
+
+	boost::filesystem::rename(temp_path, cache_path, ec);
+	if (ec) {
+		boost::filesystem::remove(temp_path, ec);
+		*error = "Cannot replace config cache file: " + cache_path.string();
+		return false;
+	}
+	return true;
+}
+
+void ConfigCache::WriteProgram(const CompiledTemplate& compiled, std::string* buffer) {
+	BinaryWriter writer(buffer);
+	writer.WritePod(static_cast<uint64_t>(compiled.literal_size_));
+	writer.WriteBool(compiled.has_sections_);
+	writer.WriteSize(compiled.program_.size());
+	for (const auto& instruction : compiled.program_) {
+		writer.WritePod(static_cast<uint8_t>(instruction.op));
+		writer.WritePod(instruction.offset);
+		writer.WritePod(instruction.length);
+		writer.WritePod(instruction.target);
+	}
+}
+
+bool ConfigCache::ReadProgram(const char** data, const char* end, CompiledTemplate* compiled) {
+	BinaryReader reader(*data, end);
+	uint64_t literal_size = 0;
+	size_t count = 0;
+	if (!reader.ReadPod(&literal_size) || !reader.ReadBool(&compiled->has_sections_) || !reader.ReadCount(&count)) {
+		return false;
+	}
+	compiled->literal_size_ = static_cast<size_t>(literal_size);
+	compiled->program_.resize(count);
+	for (auto& instruction : compiled->program_) {
+		uint8_t op = 0;
+		if (!reader.ReadPod(&op) || op > static_cast<uint8_t>(CompiledTemplate::OpCode::JUMP) ||
+				!reader.ReadPod(&instruction.offset) || !reader.ReadPod(&instruction.length) ||
+				!reader.ReadPod(&instruction.target)) {
+			return false;
+		}
+		instruction.op = static_cast<CompiledTemplate::OpCode>(op);
+		// 指令引用的原文范围和跳转目标必须有效，否则执行时会越界
+		if (static_cast<size_t>(instruction.offset) + instruction.length > compiled->text_.size() ||
+				instruction.target > count) {
+			return false;
+		}
+	}
+	*data = reader.Position();
+	return true;
+}
+
+} // namespace code_generator
@@ -0,0 +1,727 @@
+// 由cppcodegen --generate-config-json根据src/config_schema.cpp中的描述生成，请勿手工修改
+#include "code_generator/config_parser.h"
+#include "code_generator/json_writer.h"
+#include <cstdint>
+
+namespace code_generator {
+
+namespace {
+
+// FNV-1a，与ConfigSchemaCompiler::KeyHash一致，case中的常量由它在生成时算出
+uint32_t ConfigKeyHash(json::string_view key)
+{
+	uint32_t hash = 2166136261u;
+	for (char c : key) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	return hash;
+}
+
+} // namespace
+
+CodeGenConfig::FunctionConfig CodeGenConfig::FunctionConfig::FromJson(const json::value& json)
+{
+	FunctionConfig config;
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x8d39bde6u:
+			if (key == "name" && value.is_string()) {
+				config.name = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x43f33808u:
+			if (key == "return_type" && value.is_string()) {
+				config.return_type = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0xdbaa7975u:
+			if (key == "body" && value.is_string()) {
+				config.body = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x1126caebu:
+			if (key == "access" && value.is_string()) {
+				config.access = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x5d967ebcu:
+			if (key == "virtual" && value.is_bool()) {
+				config.is_virtual = value.as_bool();
+			}
+			break;
+		case 0x81837f97u:
+			if (key == "pure_virtual" && value.is_bool()) {
+				config.is_pure_virtual = value.as_bool();
+			}
+			break;
+		case 0x664fd1d4u:
+			if (key == "const" && value.is_bool()) {
+				config.is_const = value.as_bool();
+			}
+			break;
+		case 0xd290c23bu:
+			if (key == "static" && value.is_bool()) {
+				config.is_static = value.as_bool();
+			}
+			break;
+		case 0x388a5ae8u:
+			if (key == "templates" && value.is_array()) {
+				config.templates = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x48a52ed9u:
+			if (key == "parameters" && value.is_array()) {
+				for (const auto& item : value.as_array()) {
+					const json::object* parameter = item.if_object();
+					if (!parameter) {
+						continue;
+					}
+					std::string type, name;
+					for (const auto& attribute : *parameter) {
+						if (!attribute.value().is_string()) {
+							continue;
+						}
+						if (attribute.key() == "type") {
+							type = ConfigParser::JsonToString(attribute.value());
+						} else if (attribute.key() == "name") {
+							name = ConfigParser::JsonToString(attribute.value());
+						}
+					}
+					if (!type.empty() && !name.empty()) {
+						config.parameters.emplace_back(std::move(type), std::move(name));
+					}
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::FunctionConfig::ToJson() const
+{
+	json::object obj;
+	obj.reserve(10);
+	obj["name"] = name;
+	obj["return_type"] = return_type;
+	obj["body"] = body;
+	obj["access"] = access;
+	obj["virtual"] = is_virtual;
+	obj["pure_virtual"] = is_pure_virtual;
+	obj["const"] = is_const;
+	obj["static"] = is_static;
+	obj["templates"] = ConfigParser::StringVectorToJsonArray(templates);
+	json::array parameters_array;
+	parameters_array.reserve(parameters.size());
+	for (const auto& item : parameters) {
+		json::object parameter;
+		parameter["type"] = item.first;
+		parameter["name"] = item.second;
+		parameters_array.push_back(std::move(parameter));
+	}
+	obj["parameters"] = std::move(parameters_array);
+	return obj;
+}
+
+void CodeGenConfig::FunctionConfig::WriteJson(JsonWriter& writer) const
+{
+	writer.BeginObject();
+	writer.Key("name");
+	writer.String(name);
+	writer.Key("return_type");
+	writer.String(return_type);
+	writer.Key("body");
+	writer.String(body);
+	writer.Key("access");
+	writer.String(access);
+	writer.Key("virtual");
+	writer.Bool(is_virtual);
+	writer.Key("pure_virtual");
+	writer.Bool(is_pure_virtual);
+	writer.Key("const");
+	writer.Bool(is_const);
+	writer.Key("static");
+	writer.Bool(is_static);
+	writer.Key("templates");
+	writer.StringArray(templates);
+	writer.Key("parameters");
+	writer.BeginArray();
+	for (const auto& item : parameters) {
+		writer.BeginObject();
+		writer.Key("type");
+		writer.String(item.first);
+		writer.Key("name");
+		writer.String(item.second);
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+}
+
+CodeGenConfig::MemberConfig CodeGenConfig::MemberConfig::FromJson(const json::value& json)
+{
+	MemberConfig config;
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x8d39bde6u:
+			if (key == "name" && value.is_string()) {
+				config.name = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x5127f14du:
+			if (key == "type" && value.is_string()) {
+				config.type = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x69c27bbbu:
+			if (key == "initializer" && value.is_string()) {
+				config.initializer = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x1126caebu:
+			if (key == "access" && value.is_string()) {
+				config.access = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x67a6c45eu:
+			if (key == "comment" && value.is_string()) {
+				config.comment = ConfigParser::JsonToString(value);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::MemberConfig::ToJson() const
+{
+	json::object obj;
+	obj.reserve(5);
+	obj["name"] = name;
+	obj["type"] = type;
+	obj["initializer"] = initializer;
+	obj["access"] = access;
+	obj["comment"] = comment;
+	return obj;
+}
+
+void CodeGenConfig::MemberConfig::WriteJson(JsonWriter& writer) const
+{
+	writer.BeginObject();
+	writer.Key("name");
+	writer.String(name);
+	writer.Key("type");
+	writer.String(type);
+	writer.Key("initializer");
+	writer.String(initializer);
+	writer.Key("access");
+	writer.String(access);
+	writer.Key("comment");
+	writer.String(comment);
+	writer.EndObject();
+}
+
+CodeGenConfig::ClassConfig CodeGenConfig::ClassConfig::FromJson(const json::value& json)
+{
+	ClassConfig config;
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x8d39bde6u:
+			if (key == "name" && value.is_string()) {
+				config.name = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x4a82d167u:
+			if (key == "base_classes" && value.is_array()) {
+				config.base_classes = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x388a5ae8u:
+			if (key == "templates" && value.is_array()) {
+				config.templates = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x66225340u:
+			if (key == "metadata" && value.is_object()) {
+				ConfigParser::JsonObjectToStringMap(value, &config.metadata);
+			}
+			break;
+		case 0x454a414eu:
+			if (key == "functions" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.functions.reserve(items.size());
+				for (const auto& item : items) {
+					config.functions.push_back(FunctionConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x37e24810u:
+			if (key == "members" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.members.reserve(items.size());
+				for (const auto& item : items) {
+					config.members.push_back(MemberConfig::FromJson(item));
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::ClassConfig::ToJson() const
+{
+	json::object obj;
+	obj.reserve(6);
+	obj["name"] = name;
+	obj["base_classes"] = ConfigParser::StringVectorToJsonArray(base_classes);
+	obj["templates"] = ConfigParser::StringVectorToJsonArray(templates);
+	obj["metadata"] = ConfigParser::StringMapToJsonObject(metadata);
+	json::array functions_array;
+	functions_array.reserve(functions.size());
+	for (const auto& item : functions) {
+		functions_array.push_back(item.ToJson());
+	}
+	obj["functions"] = std::move(functions_array);
+	json::array members_array;
+	members_array.reserve(members.size());
+	for (const auto& item : members) {
+		members_array.push_back(item.ToJson());
+	}
+	obj["members"] = std::move(members_array);
+	return obj;
+}
+
+void CodeGenConfig::ClassConfig::WriteJson(JsonWriter& writer) const
+{
+	writer.BeginObject();
+	writer.Key("name");
+	writer.String(name);
+	writer.Key("base_classes");
+	writer.StringArray(base_classes);
+	writer.Key("templates");
+	writer.StringArray(templates);
+	writer.Key("metadata");
+	writer.StringObject(metadata);
+	writer.Key("functions");
+	writer.BeginArray();
+	for (const auto& item : functions) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("members");
+	writer.BeginArray();
+	for (const auto& item : members) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.EndObject();
+}
+
+CodeGenConfig::SnippetConfig CodeGenConfig::SnippetConfig::FromJson(const json::value& json)
+{
+	SnippetConfig config;
+	if (json.is_string()) {
+		config.reference = ConfigParser::JsonToString(json);
+		return config;
+	}
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x5a81f39au:
+			if (key == "reference" && value.is_string()) {
+				config.reference = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x42edcab4u:
+			if (key == "anchor" && value.is_string()) {
+				config.anchor = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x32608848u:
+			if (key == "target" && value.is_string()) {
+				config.target = ConfigParser::JsonToString(value);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::SnippetConfig::ToJson() const
+{
+	const SnippetConfig defaults;
+	if (anchor == defaults.anchor && target == defaults.target) {
+		return json::value(reference);
+	}
+
+	json::object obj;
+	obj.reserve(3);
+	obj["reference"] = reference;
+	obj["anchor"] = anchor;
+	obj["target"] = target;
+	return obj;
+}
+
+void CodeGenConfig::SnippetConfig::WriteJson(JsonWriter& writer) const
+{
+	const SnippetConfig defaults;
+	if (anchor == defaults.anchor && target == defaults.target) {
+		writer.String(reference);
+		return;
+	}
+
+	writer.BeginObject();
+	writer.Key("reference");
+	writer.String(reference);
+	writer.Key("anchor");
+	writer.String(anchor);
+	writer.Key("target");
+	writer.String(target);
+	writer.EndObject();
+}
+
+CodeGenConfig::FileConfig CodeGenConfig::FileConfig::FromJson(const json::value& json)
+{
+	FileConfig config;
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x3f110988u:
+			if (key == "filename" && value.is_string()) {
+				config.filename = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x5127f14du:
+			if (key == "type" && value.is_string()) {
+				config.type = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x89cd6448u:
+			if (key == "source_filename" && value.is_string()) {
+				config.source_filename = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0xcfdb2d7cu:
+			if (key == "includes" && value.is_array()) {
+				config.includes = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x160b5a29u:
+			if (key == "namespaces" && value.is_array()) {
+				config.namespaces = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x7c9fed9cu:
+			if (key == "copy_files" && value.is_array()) {
+				config.copy_files = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x8ca3a107u:
+			if (key == "insert_snippets" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.insert_snippets.reserve(items.size());
+				for (const auto& item : items) {
+					config.insert_snippets.push_back(SnippetConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x702da6a7u:
+			if (key == "classes" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.classes.reserve(items.size());
+				for (const auto& item : items) {
+					config.classes.push_back(ClassConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x454a414eu:
+			if (key == "functions" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.functions.reserve(items.size());
+				for (const auto& item : items) {
+					config.functions.push_back(FunctionConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x1577cde7u:
+			if (key == "globals" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.globals.reserve(items.size());
+				for (const auto& item : items) {
+					config.globals.push_back(MemberConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x388a5ae8u:
+			if (key == "templates" && value.is_object()) {
+				ConfigParser::JsonObjectToStringMap(value, &config.templates);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::FileConfig::ToJson() const
+{
+	json::object obj;
+	obj.reserve(11);
+	obj["filename"] = filename;
+	obj["type"] = type;
+	obj["source_filename"] = source_filename;
+	obj["includes"] = ConfigParser::StringVectorToJsonArray(includes);
+	obj["namespaces"] = ConfigParser::StringVectorToJsonArray(namespaces);
+	obj["copy_files"] = ConfigParser::StringVectorToJsonArray(copy_files);
+	json::array insert_snippets_array;
+	insert_snippets_array.reserve(insert_snippets.size());
+	for (const auto& item : insert_snippets) {
+		insert_snippets_array.push_back(item.ToJson());
+	}
+	obj["insert_snippets"] = std::move(insert_snippets_array);
+	json::array classes_array;
+	classes_array.reserve(classes.size());
+	for (const auto& item : classes) {
+		classes_array.push_back(item.ToJson());
+	}
+	obj["classes"] = std::move(classes_array);
+	json::array functions_array;
+	functions_array.reserve(functions.size());
+	for (const auto& item : functions) {
+		functions_array.push_back(item.ToJson());
+	}
+	obj["functions"] = std::move(functions_array);
+	json::array globals_array;
+	globals_array.reserve(globals.size());
+	for (const auto& item : globals) {
+		globals_array.push_back(item.ToJson());
+	}
+	obj["globals"] = std::move(globals_array);
+	obj["templates"] = ConfigParser::StringMapToJsonObject(templates);
+	return obj;
+}
+
+void CodeGenConfig::FileConfig::WriteJson(JsonWriter& writer) const
+{
+	writer.BeginObject();
+	writer.Key("filename");
+	writer.String(filename);
+	writer.Key("type");
+	writer.String(type);
+	writer.Key("source_filename");
+	writer.String(source_filename);
+	writer.Key("includes");
+	writer.StringArray(includes);
+	writer.Key("namespaces");
+	writer.StringArray(namespaces);
+	writer.Key("copy_files");
+	writer.StringArray(copy_files);
+	writer.Key("insert_snippets");
+	writer.BeginArray();
+	for (const auto& item : insert_snippets) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("classes");
+	writer.BeginArray();
+	for (const auto& item : classes) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("functions");
+	writer.BeginArray();
+	for (const auto& item : functions) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("globals");
+	writer.BeginArray();
+	for (const auto& item : globals) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("templates");
+	writer.StringObject(templates);
+	writer.EndObject();
+}
+
+CodeGenConfig::ProjectConfig CodeGenConfig::ProjectConfig::FromJson(const json::value& json)
+{
+	ProjectConfig config;
+	const json::object* obj = json.if_object();
+	if (!obj) {
+		return config;
+	}
+
+	// 一次遍历对象成员，按键的哈希值分派到字段
+	for (const auto& iter : *obj) {
+		const json::string_view key = iter.key();
+		const json::value& value = iter.value();
+		switch (ConfigKeyHash(key)) {
+		case 0x8d39bde6u:
+			if (key == "name" && value.is_string()) {
+				config.name = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x4671ae97u:
+			if (key == "version" && value.is_string()) {
+				config.version = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0x09668c30u:
+			if (key == "output_dir" && value.is_string()) {
+				config.output_dir = ConfigParser::JsonToString(value);
+			}
+			break;
+		case 0xad01b6e5u:
+			if (key == "imports" && value.is_array()) {
+				config.imports = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x9ddf8b70u:
+			if (key == "common_includes" && value.is_array()) {
+				config.common_includes = ConfigParser::JsonArrayToStringVector(value);
+			}
+			break;
+		case 0x3ee74090u:
+			if (key == "files" && value.is_array()) {
+				const json::array& items = value.as_array();
+				config.files.reserve(items.size());
+				for (const auto& item : items) {
+					config.files.push_back(FileConfig::FromJson(item));
+				}
+			}
+			break;
+		case 0x29ab62c2u:
+			if (key == "variables" && value.is_object()) {
+				ConfigParser::JsonObjectToStringMap(value, &config.variables);
+				for (const auto& variable : value.as_object()) {
+					if (!variable.value().is_string()) {
+						config.structured_variables.emplace(variable.key(), variable.value());
+					}
+				}
+			}
+			break;
+		case 0xa8b72e4cu:
+			if (key == "code_templates" && value.is_object()) {
+				ConfigParser::JsonObjectToStringMap(value, &config.code_templates);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return config;
+}
+
+json::value CodeGenConfig::ProjectConfig::ToJson() const
+{
+	json::object obj;
+	obj.reserve(7);
+	obj["name"] = name;
+	obj["version"] = version;
+	obj["output_dir"] = output_dir;
+	obj["common_includes"] = ConfigParser::StringVectorToJsonArray(common_includes);
+	json::array files_array;
+	files_array.reserve(files.size());
+	for (const auto& item : files) {
+		files_array.push_back(item.ToJson());
+	}
+	obj["files"] = std::move(files_array);
+	json::object variables_object = ConfigParser::StringMapToJsonObject(variables).as_object();
+	for (const auto& item : structured_variables) {
+		variables_object.emplace(item.key(), item.value());
+	}
+	obj["variables"] = std::move(variables_object);
+	obj["code_templates"] = ConfigParser::StringMapToJsonObject(code_templates);
+	return obj;
+}
+
+void CodeGenConfig::ProjectConfig::WriteJson(JsonWriter& writer) const
+{
+	writer.BeginObject();
+	writer.Key("name");
+	writer.String(name);
+	writer.Key("version");
+	writer.String(version);
+	writer.Key("output_dir");
+	writer.String(output_dir);
+	writer.Key("common_includes");
+	writer.StringArray(common_includes);
+	writer.Key("files");
+	writer.BeginArray();
+	for (const auto& item : files) {
+		item.WriteJson(writer);
+	}
+	writer.EndArray();
+	writer.Key("variables");
+	writer.BeginObject();
+	for (const auto& item : variables) {
+		writer.Key(item.first);
+		writer.String(item.second);
+	}
+	for (const auto& item : structured_variables) {
+		writer.Key(item.key().data(), item.key().size());
+		writer.Value(item.value());
+	}
+	writer.EndObject();
+	writer.Key("code_templates");
+	writer.StringObject(code_templates);
+	writer.EndObject();
+}
+
+} // namespace code_generator
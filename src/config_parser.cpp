@@ -1,4 +1,18 @@
 #include "code_generator/config_parser.h"
+#include "code_generator/binary_config.h"
+#include "code_generator/code_library_cache.h"
+#include "code_generator/config_cache.h"
+#include "code_generator/config_validator.h"
+#include "code_generator/import_cache.h"
+#include "code_generator/json_writer.h"
+#include "code_generator/file_streams.h"
+#include "code_generator/stream_adapters.h"
+#include <boost/version.hpp>
+#if BOOST_VERSION >= 107600
+#include <boost/json/basic_parser_impl.hpp>
+#else
+#include <boost/json/basic_parser.hpp>
+#endif
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -7,406 +21,598 @@
 
 namespace code_generator {
 
-// ClassConfig实现
-CodeGenConfig::ClassConfig CodeGenConfig::ClassConfig::FromJson(const json::value& json) {
-	ClassConfig config;
+// FromJson/ToJson由config_schema.cpp中的描述生成，见config_json.cpp
 
+void CodeGenConfig::LoadVariables(const json::value& json, StringMap& variables) {
 	if (json.is_object()) {
-		const json::object& obj = json.as_object();
-
-		// 名称
-		if (obj.contains("name") && obj.at("name").is_string()) {
-			config.name = obj.at("name").as_string().c_str();
+		// 变量映射
+		const json::value* value = json.as_object().if_contains("variables");
+		if (value && value->is_object()) {
+			variables.clear();
+			ConfigParser::JsonObjectToStringMap(*value, &variables);
 		}
+	}
+}
 
-		// 基类
-		if (obj.contains("base_classes") && obj.at("base_classes").is_array()) {
-			config.base_classes = code_generator::ConfigParser::JsonArrayToStringVector(obj.at("base_classes"));
-		}
+// ConfigParser实现
+ConfigParser::ConfigParser() : error_message_("") {}
 
-		// 模板
-		if (obj.contains("templates") && obj.at("templates").is_array()) {
-			config.templates = code_generator::ConfigParser::JsonArrayToStringVector(obj.at("templates"));
+bool ConfigParser::LoadFromFile(const boost::filesystem::path& filename) {
+	try {
+		if (!boost::filesystem::exists(filename)) {
+			SetError("Config file does not exist: " + filename.string());
+			return false;
 		}
 
-		// 元数据
-		if (obj.contains("metadata") && obj.at("metadata").is_object()) {
-			config.metadata = code_generator::ConfigParser::JsonObjectToStringMap(obj.at("metadata"));
+		// 配置也可以是CBOR或MessagePack，按二进制读入
+		std::ifstream file(filename.string(), std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			SetError("Cannot open config file: " + filename.string());
+			return false;
 		}
-	}
-
-	return config;
-}
 
-json::value CodeGenConfig::ClassConfig::ToJson() const {
-	json::object obj;
-	obj["name"] = name;
-	obj["base_classes"] = ConfigParser::StringVectorToJsonArray(base_classes);
-	obj["templates"] = ConfigParser::StringVectorToJsonArray(templates);
-	obj["metadata"] = ConfigParser::StringMapToJsonObject(metadata);
-	return obj;
-}
-
-// FunctionConfig实现
-CodeGenConfig::FunctionConfig CodeGenConfig::FunctionConfig::FromJson(const json::value& json) {
-	FunctionConfig config;
-
-	if (json.is_object()) {
-		const json::object& obj = json.as_object();
+		// 按文件大小一次读入，不经过stringstream
+		std::string content;
+		file.seekg(0, std::ios::end);
+		std::streamoff file_size = file.tellg();
+		file.seekg(0, std::ios::beg);
+		if (file_size > 0) {
+			content.resize(static_cast<size_t>(file_size));
+			file.read(&content[0], file_size);
+			content.resize(static_cast<size_t>(file.gcount()));
+		}
 
-		// 基本信息
-		if (obj.contains("name") && obj.at("name").is_string()) {
-			config.name = obj.at("name").as_string().c_str();
+		uint64_t cache_key = 0;
+		if (!cache_directory_.empty()) {
+			cache_key = ConfigCache::ComputeKey(content);
+			if (LoadFromCache(filename, cache_key)) {
+				// SetValidateOnLoad(false)时加载的配置也会写入缓存，命中后按本次的设置校验
+				return !validate_on_load_ || ValidateConfig();
+			}
 		}
-		if (obj.contains("return_type") && obj.at("return_type").is_string()) {
-			config.return_type = obj.at("return_type").as_string().c_str();
+
+		std::shared_ptr<json::value> document;
+		if (!ParseDocument(content, &document) || !ResolveImports(document.get(), filename.parent_path())) {
+			return false;
 		}
-		if (obj.contains("body") && obj.at("body").is_string()) {
-			config.body = obj.at("body").as_string().c_str();
+
+		// 只解析一次，在字符串值上替换变量，变量值中的引号等字符不会破坏JSON结构
+		// 变量按需展开，只有被引用的变量才会求值
+		StringMap variables;
+		CodeGenConfig::LoadVariables(*document, variables);
+		if (!variables.empty()) {
+			VariableResolver resolver(variables);
+			if (!SubstituteVariables(document.get(), &resolver)) {
+				return false;
+			}
 		}
-		if (obj.contains("access") && obj.at("access").is_string()) {
-			config.access = obj.at("access").as_string().c_str();
+		// LoadFromJson把字符串拷贝到配置结构中，转换完成后文档和内存池随document一起释放
+		if (!LoadFromJson(*document)) {
+			return false;
 		}
 
-		// 布尔属性
-		config.is_virtual = obj.contains("virtual") && obj.at("virtual").is_bool() && obj.at("virtual").as_bool();
-		config.is_pure_virtual = obj.contains("pure_virtual") && obj.at("pure_virtual").is_bool() && obj.at("pure_virtual").as_bool();
-		config.is_const = obj.contains("const") && obj.at("const").is_bool() && obj.at("const").as_bool();
-		config.is_static = obj.contains("static") && obj.at("static").is_bool() && obj.at("static").as_bool();
-
-		// 模板
-		if (obj.contains("templates") && obj.at("templates").is_array()) {
-			config.templates = ConfigParser::JsonArrayToStringVector(obj.at("templates"));
+		if (!cache_directory_.empty()) {
+			// 缓存写入失败不影响本次加载，下次运行重新解析
+			std::string cache_error;
+			ConfigCache(cache_directory_).Store(filename, cache_key, imported_files_, project_config_, compiled_templates_,
+												&cache_error);
 		}
+		return true;
 
-		// 参数
-		if (obj.contains("parameters") && obj.at("parameters").is_array()) {
-			const json::array& params = obj.at("parameters").as_array();
-			for (const auto& param : params) {
-				if (param.is_object()) {
-					const json::object& param_obj = param.as_object();
-					std::string type, name;
-
-					if (param_obj.contains("type") && param_obj.at("type").is_string()) {
-						type = param_obj.at("type").as_string().c_str();
-					}
-					if (param_obj.contains("name") && param_obj.at("name").is_string()) {
-						name = param_obj.at("name").as_string().c_str();
-					}
-
-					if (!type.empty() && !name.empty()) {
-						config.parameters.emplace_back(type, name);
-					}
-				}
-			}
-		}
+	} catch (const std::exception& e) {
+		SetError("File loading error: " + std::string(e.what()));
+		return false;
 	}
-
-	return config;
 }
 
-json::value CodeGenConfig::FunctionConfig::ToJson() const {
-	json::object obj;
-	obj["name"] = name;
-	obj["return_type"] = return_type;
-	obj["body"] = body;
-	obj["access"] = access;
-	obj["virtual"] = is_virtual;
-	obj["pure_virtual"] = is_pure_virtual;
-	obj["const"] = is_const;
-	obj["static"] = is_static;
-	obj["templates"] = ConfigParser::StringVectorToJsonArray(templates);
-
-	// 参数数组
-	json::array params_array;
-	//for (const auto& [type, name] : parameters) {
-	for (const auto& iter : parameters) {
-		const std::string& type = iter.first;
-		const std::string& name = iter.second;
-		json::object param_obj;
-		param_obj["type"] = type;
-		param_obj["name"] = name;
-		params_array.push_back(param_obj);
+bool ConfigParser::LoadFromCache(const boost::filesystem::path& filename, uint64_t key) {
+	CodeGenConfig::ProjectConfig config;
+	FlatStringMap<CompiledTemplate> templates;
+	std::map<std::string, uint64_t> imported_files;
+	if (!ConfigCache(cache_directory_).Load(filename, key, &imported_files, &config, &templates)) {
+		return false;
 	}
-	obj["parameters"] = params_array;
 
-	return obj;
+	// 缓存中的配置不一定通过了校验，由调用者按validate_on_load_检查
+	project_config_ = std::move(config);
+	compiled_templates_ = std::move(templates);
+	imported_files_ = std::move(imported_files);
+	BuildVariableMap();
+	FindNativeTemplates();
+	error_message_.clear();
+	return true;
 }
 
-// MemberConfig实现
-CodeGenConfig::MemberConfig CodeGenConfig::MemberConfig::FromJson(const json::value& json) {
-	MemberConfig config;
-
-	if (json.is_object()) {
-		const json::object& obj = json.as_object();
-
-		if (obj.contains("name") && obj.at("name").is_string()) {
-			config.name = obj.at("name").as_string().c_str();
-		}
-		if (obj.contains("type") && obj.at("type").is_string()) {
-			config.type = obj.at("type").as_string().c_str();
-		}
-		if (obj.contains("initializer") && obj.at("initializer").is_string()) {
-			config.initializer = obj.at("initializer").as_string().c_str();
-		}
-		if (obj.contains("access") && obj.at("access").is_string()) {
-			config.access = obj.at("access").as_string().c_str();
-		}
-		if (obj.contains("comment") && obj.at("comment").is_string()) {
-			config.comment = obj.at("comment").as_string().c_str();
-		}
+bool ConfigParser::LoadFromString(const std::string& json_str) {
+	std::shared_ptr<json::value> document;
+	if (!ParseDocument(json_str, &document) || !ResolveImports(document.get(), boost::filesystem::current_path()) ||
+			!LoadFromJson(*document)) {
+		return false;
 	}
-
-	return config;
+	return true;
 }
 
-json::value CodeGenConfig::MemberConfig::ToJson() const {
-	json::object obj;
-	obj["name"] = name;
-	obj["type"] = type;
-	obj["initializer"] = initializer;
-	obj["access"] = access;
-	obj["comment"] = comment;
-	return obj;
-}
+// 流式解析事件处理：顶层的每个设置和files中的每个元素各自构建为一个独立的JSON值，
+// 完成后立即交给ConfigParser，files数组本身不会被构建
+class ConfigParser::StreamHandler {
+public:
+	static constexpr std::size_t max_object_size = json::object::max_size();
+	static constexpr std::size_t max_array_size = json::array::max_size();
+	static constexpr std::size_t max_key_size = json::string::max_size();
+	static constexpr std::size_t max_string_size = json::string::max_size();
 
-// FileConfig实现
-CodeGenConfig::FileConfig CodeGenConfig::FileConfig::FromJson(const json::value& json) {
-	FileConfig config;
+	StreamHandler(ConfigParser* parser, const ProjectCallback* on_project, const FileCallback* on_file)
+			: parser_(parser), on_project_(on_project), on_file_(on_file), depth_(0),
+			  in_files_(false), files_seen_(false), header_done_(false), file_count_(0) {}
 
-	if (json.is_object()) {
-		const json::object& obj = json.as_object();
+	size_t FileCount() const { return file_count_; }
 
-		// 基本属性
-		if (obj.contains("filename") && obj.at("filename").is_string()) {
-			config.filename = obj.at("filename").as_string().c_str();
+	bool on_document_begin(json::error_code& ec) { return true; }
+	bool on_document_end(json::error_code& ec) {
+		if (!header_done_ && !FinishHeader(ec)) {
+			return false;
 		}
-		if (obj.contains("type") && obj.at("type").is_string()) {
-			config.type = obj.at("type").as_string().c_str();
+		if (file_count_ == 0) {
+			return Fail("At least one file must be specified", ec);
 		}
+		return true;
+	}
 
-		// 数组属性
-		if (obj.contains("includes") && obj.at("includes").is_array()) {
-			config.includes = ConfigParser::JsonArrayToStringVector(obj.at("includes"));
+	bool on_object_begin(json::error_code& ec) {
+		if (depth_ == 0) {
+			depth_ = 1;
+			return true;
 		}
-		if (obj.contains("namespaces") && obj.at("namespaces").is_array()) {
-			config.namespaces = ConfigParser::JsonArrayToStringVector(obj.at("namespaces"));
+		BeginValue();
+		++depth_;
+		return true;
+	}
+
+	bool on_object_end(std::size_t n, json::error_code& ec) {
+		if (depth_ == 1) {
+			depth_ = 0;
+			return true;
 		}
-		if (obj.contains("copy_files") && obj.at("copy_files").is_array()) {
-			config.copy_files = ConfigParser::JsonArrayToStringVector(obj.at("copy_files"));
+		value_.push_object(n);
+		--depth_;
+		return EndValue(ec);
+	}
+
+	bool on_array_begin(json::error_code& ec) {
+		if (depth_ == 0) {
+			return Fail("Config root must be an object", ec);
 		}
-		if (obj.contains("insert_snippets") && obj.at("insert_snippets").is_array()) {
-			config.insert_snippets = ConfigParser::JsonArrayToStringVector(obj.at("insert_snippets"));
+		if (depth_ == 1 && key_ == "files") {
+			if (files_seen_) {
+				return Fail("Duplicate 'files' array", ec);
+			}
+			if (!FinishHeader(ec)) {
+				return false;
+			}
+			files_seen_ = true;
+			in_files_ = true;
+			depth_ = 2;
+			return true;
 		}
+		BeginValue();
+		++depth_;
+		return true;
+	}
 
-		// 类数组
-		if (obj.contains("classes") && obj.at("classes").is_array()) {
-			const json::array& classes = obj.at("classes").as_array();
-			for (const auto& class_json : classes) {
-				config.classes.push_back(ClassConfig::FromJson(class_json));
-			}
+	bool on_array_end(std::size_t n, json::error_code& ec) {
+		if (in_files_ && depth_ == 2) {
+			in_files_ = false;
+			depth_ = 1;
+			return true;
 		}
+		value_.push_array(n);
+		--depth_;
+		return EndValue(ec);
+	}
 
-		// 函数数组
-		if (obj.contains("functions") && obj.at("functions").is_array()) {
-			const json::array& functions = obj.at("functions").as_array();
-			for (const auto& func_json : functions) {
-				config.functions.push_back(FunctionConfig::FromJson(func_json));
-			}
+	bool on_key_part(json::string_view s, std::size_t n, json::error_code& ec) {
+		if (depth_ == 1) {
+			AppendKey(s, n);
+		} else {
+			value_.push_chars(s);
 		}
+		return true;
+	}
 
-		// 全局变量数组
-		if (obj.contains("globals") && obj.at("globals").is_array()) {
-			const json::array& globals = obj.at("globals").as_array();
-			for (const auto& global_json : globals) {
-				config.globals.push_back(MemberConfig::FromJson(global_json));
-			}
+	bool on_key(json::string_view s, std::size_t n, json::error_code& ec) {
+		if (depth_ != 1) {
+			value_.push_key(s);
+			return true;
+		}
+		AppendKey(s, n);
+		// 项目设置必须在生成第一个文件之前确定
+		if (files_seen_ && (key_ == "name" || key_ == "version" || key_ == "output_dir" || key_ == "variables" ||
+							key_ == "common_includes" || key_ == "code_templates")) {
+			return Fail("'" + key_ + "' must precede 'files' when loading in streaming mode", ec);
 		}
+		return true;
+	}
 
-		// 模板映射
-		if (obj.contains("templates") && obj.at("templates").is_object()) {
-			config.templates = ConfigParser::JsonObjectToStringMap(obj.at("templates"));
+	bool on_string_part(json::string_view s, std::size_t n, json::error_code& ec) {
+		if (n == s.size()) {
+			BeginValue();
 		}
+		value_.push_chars(s);
+		return true;
 	}
 
-	return config;
-}
+	bool on_string(json::string_view s, std::size_t n, json::error_code& ec) {
+		if (n == s.size()) {
+			BeginValue();
+		}
+		value_.push_string(s);
+		return EndValue(ec);
+	}
 
-json::value CodeGenConfig::FileConfig::ToJson() const {
-	json::object obj;
-	obj["filename"] = filename;
-	obj["type"] = type;
-	obj["includes"] = ConfigParser::StringVectorToJsonArray(includes);
-	obj["namespaces"] = ConfigParser::StringVectorToJsonArray(namespaces);
-	obj["copy_files"] = ConfigParser::StringVectorToJsonArray(copy_files);
-	obj["insert_snippets"] = ConfigParser::StringVectorToJsonArray(insert_snippets);
+	bool on_number_part(json::string_view s, json::error_code& ec) { return true; }
 
-	// 类数组
-	json::array classes_array;
-	for (const auto& class_config : classes) {
-		classes_array.push_back(class_config.ToJson());
+	bool on_int64(int64_t i, json::string_view s, json::error_code& ec) {
+		BeginValue();
+		value_.push_int64(i);
+		return EndValue(ec);
 	}
-	obj["classes"] = classes_array;
 
-	// 函数数组
-	json::array functions_array;
-	for (const auto& func_config : functions) {
-		functions_array.push_back(func_config.ToJson());
+	bool on_uint64(uint64_t u, json::string_view s, json::error_code& ec) {
+		BeginValue();
+		value_.push_uint64(u);
+		return EndValue(ec);
 	}
-	obj["functions"] = functions_array;
 
-	// 全局变量数组
-	json::array globals_array;
-	for (const auto& global_config : globals) {
-		globals_array.push_back(global_config.ToJson());
+	bool on_double(double d, json::string_view s, json::error_code& ec) {
+		BeginValue();
+		value_.push_double(d);
+		return EndValue(ec);
 	}
-	obj["globals"] = globals_array;
-
-	obj["templates"] = ConfigParser::StringMapToJsonObject(templates);
 
-	return obj;
-}
+	bool on_bool(bool b, json::error_code& ec) {
+		BeginValue();
+		value_.push_bool(b);
+		return EndValue(ec);
+	}
 
-// ProjectConfig实现
-CodeGenConfig::ProjectConfig CodeGenConfig::ProjectConfig::FromJson(const json::value& json) {
-	ProjectConfig config;
+	bool on_null(json::error_code& ec) {
+		BeginValue();
+		value_.push_null();
+		return EndValue(ec);
+	}
 
-	if (json.is_object()) {
-		const json::object& obj = json.as_object();
+	bool on_comment_part(json::string_view s, json::error_code& ec) { return true; }
+	bool on_comment(json::string_view s, json::error_code& ec) { return true; }
+
+private:
+	ConfigParser* parser_;
+	const ProjectCallback* on_project_;
+	const FileCallback* on_file_;
+	json::value_stack value_;
+	json::object header_;
+	std::string key_;
+	int depth_;
+	bool in_files_;
+	bool files_seen_;
+	bool header_done_;
+	size_t file_count_;
+
+	// 独立构建的值位于顶层对象之下，或位于files数组之下
+	int RootDepth() const { return in_files_ ? 2 : 1; }
+
+	void BeginValue() {
+		if (depth_ == RootDepth()) {
+			value_.reset();
+		}
+	}
 
-		// 基本属性
-		if (obj.contains("name") && obj.at("name").is_string()) {
-			config.name = obj.at("name").as_string().c_str();
+	bool EndValue(json::error_code& ec) {
+		if (depth_ != RootDepth()) {
+			return true;
 		}
-		if (obj.contains("version") && obj.at("version").is_string()) {
-			config.version = obj.at("version").as_string().c_str();
+		json::value value = value_.release();
+		if (!in_files_) {
+			header_[key_] = std::move(value);
+			return true;
 		}
-		if (obj.contains("output_dir") && obj.at("output_dir").is_string()) {
-			config.output_dir = obj.at("output_dir").as_string().c_str();
+		++file_count_;
+		if (!parser_->StreamFile(&value, *on_file_)) {
+			ec = boost::system::errc::make_error_code(boost::system::errc::operation_canceled);
+			return false;
 		}
+		return true;
+	}
 
-		// 公共包含
-		if (obj.contains("common_includes") && obj.at("common_includes").is_array()) {
-			config.common_includes = ConfigParser::JsonArrayToStringVector(obj.at("common_includes"));
+	void AppendKey(json::string_view s, std::size_t n) {
+		if (n == s.size()) {
+			key_.assign(s.data(), s.size());
+		} else {
+			key_.append(s.data(), s.size());
 		}
+	}
 
-		// 文件数组
-		if (obj.contains("files") && obj.at("files").is_array()) {
-			const json::array& files = obj.at("files").as_array();
-			for (const auto& file_json : files) {
-				config.files.push_back(FileConfig::FromJson(file_json));
-			}
+	bool FinishHeader(json::error_code& ec) {
+		header_done_ = true;
+		json::value header(std::move(header_));
+		if (!parser_->BeginStream(&header, *on_project_)) {
+			ec = boost::system::errc::make_error_code(boost::system::errc::operation_canceled);
+			return false;
 		}
+		return true;
+	}
 
-		// 变量映射
-		if (obj.contains("variables") && obj.at("variables").is_object()) {
-			config.variables = ConfigParser::JsonObjectToStringMap(obj.at("variables"));
-		}
+	bool Fail(const std::string& message, json::error_code& ec) {
+		parser_->SetError(message);
+		ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+		return false;
+	}
+};
 
-		// 代码模板
-		if (obj.contains("code_templates") && obj.at("code_templates").is_object()) {
-			config.code_templates = ConfigParser::JsonObjectToStringMap(obj.at("code_templates"));
-		}
+bool ConfigParser::LoadStreaming(const boost::filesystem::path& filename, const ProjectCallback& on_project,
+								 const FileCallback& on_file) {
+	error_message_.clear();
+	project_config_ = CodeGenConfig::ProjectConfig();
+	stream_directory_ = filename.parent_path();
+	stream_outputs_ = std::make_shared<ConfigOutputPaths>();
+
+	if (!boost::filesystem::exists(filename)) {
+		SetError("Config file does not exist: " + filename.string());
+		return false;
 	}
 
-	return config;
-}
+	std::unique_ptr<MappedFile> mapped;
+	try {
+		mapped.reset(new MappedFile(filename.string()));
+	} catch (const std::exception& e) {
+		SetError("Cannot open config file: " + filename.string() + " (" + e.what() + ")");
+		return false;
+	}
 
-void CodeGenConfig::LoadVariables(const json::value& json, std::map<std::string, std::string>& variables) {
-	if (json.is_object()) {
-		const json::object& obj = json.as_object();
+	// 二进制配置的解码本身不产生文本扫描的开销，整体解码后再逐个回调files中的元素
+	if (BinaryConfigCodec::Detect(mapped->data(), mapped->size()) != ConfigFormat::JSON) {
+		return StreamDecoded(*mapped, on_project, on_file);
+	}
 
-		// 变量映射
-		if (obj.contains("variables") && obj.at("variables").is_object()) {
-			variables = ConfigParser::JsonObjectToStringMap(obj.at("variables"));
+	// 整个文件已映射到内存，一次写入解析器；元素回调在解析过程中逐个触发
+	json::basic_parser<StreamHandler> parser(json::parse_options(), this, &on_project, &on_file);
+	json::error_code ec;
+	try {
+		parser.write_some(false, mapped->data(), mapped->size(), ec);
+	} catch (const std::exception& e) {
+		SetError("Config loading error: " + std::string(e.what()));
+		return false;
+	}
+	if (ec) {
+		if (error_message_.empty()) {
+			SetError("JSON parsing error: " + ec.message());
 		}
+		return false;
 	}
+	return true;
 }
 
-json::value CodeGenConfig::ProjectConfig::ToJson() const {
-	json::object obj;
-	obj["name"] = name;
-	obj["version"] = version;
-	obj["output_dir"] = output_dir;
-	obj["common_includes"] = ConfigParser::StringVectorToJsonArray(common_includes);
+bool ConfigParser::StreamDecoded(const MappedFile& mapped, const ProjectCallback& on_project,
+								 const FileCallback& on_file) {
+	json::storage_ptr arena = json::make_shared_resource<json::monotonic_resource>(mapped.size() * 2 + 4096);
+	json::value document(arena);
+	std::string error;
+	if (!BinaryConfigCodec::Decode(BinaryConfigCodec::Detect(mapped.data(), mapped.size()), mapped.data(),
+								   mapped.size(), &document, &error)) {
+		SetError(error);
+		return false;
+	}
+	json::object* root = document.if_object();
+	if (root == nullptr) {
+		SetError("Config root must be an object");
+		return false;
+	}
+
+	// 与文档使用同一个内存池，移出files时不拷贝
+	json::value files(arena);
+	json::object::iterator iter = root->find("files");
+	if (iter != root->end()) {
+		files = std::move(iter->value());
+		root->erase(iter);
+	}
+	if (!BeginStream(&document, on_project)) {
+		return false;
+	}
+	json::array* file_array = files.if_array();
+	if (file_array == nullptr || file_array->empty()) {
+		SetError("At least one file must be specified");
+		return false;
+	}
+	for (auto& file : *file_array) {
+		if (!StreamFile(&file, on_file)) {
+			return false;
+		}
+	}
+	return true;
+}
 
-	// 文件数组
-	json::array files_array;
-	for (const auto& file_config : files) {
-		files_array.push_back(file_config.ToJson());
+bool ConfigParser::BeginStream(json::value* header, const ProjectCallback& on_project) {
+	if (!ResolveImports(header, stream_directory_)) {
+		return false;
 	}
-	obj["files"] = files_array;
 
-	obj["variables"] = ConfigParser::StringMapToJsonObject(variables);
-	obj["code_templates"] = ConfigParser::StringMapToJsonObject(code_templates);
+	StringMap variables;
+	CodeGenConfig::LoadVariables(*header, variables);
+	stream_resolver_ = VariableResolver(variables);
+	stream_has_variables_ = !variables.empty();
+	if (stream_has_variables_ && !SubstituteVariables(header, &stream_resolver_)) {
+		return false;
+	}
 
-	return obj;
+	project_config_ = CodeGenConfig::ProjectConfig::FromJson(*header);
+	if (!BuildVariableMap() || !CompileTemplates()) {
+		return false;
+	}
+	if (project_config_.name.empty()) {
+		SetError("Project name is required");
+		return false;
+	}
+	if (on_project && !on_project(project_config_)) {
+		if (error_message_.empty()) {
+			SetError("Streaming load cancelled");
+		}
+		return false;
+	}
+	return true;
 }
 
-// ConfigParser实现
-ConfigParser::ConfigParser() : error_message_("") {}
+bool ConfigParser::StreamFile(json::value* file_json, const FileCallback& on_file) {
+	if (stream_has_variables_ && !SubstituteVariables(file_json, &stream_resolver_)) {
+		return false;
+	}
+	CodeGenConfig::FileConfig file_config = CodeGenConfig::FileConfig::FromJson(*file_json);
+	if (!ValidateFileConfig(file_config)) {
+		return false;
+	}
+	if (!on_file(std::move(file_config))) {
+		if (error_message_.empty()) {
+			SetError("Streaming load cancelled");
+		}
+		return false;
+	}
+	return true;
+}
 
-bool ConfigParser::LoadFromFile(const boost::filesystem::path& filename) {
-	try {
-		if (!boost::filesystem::exists(filename)) {
-			SetError("Config file does not exist: " + filename.string());
+bool ConfigParser::ParseDocument(const std::string& text, std::shared_ptr<json::value>* document) {
+	// 解析结果通常不超过文本长度的两倍，大配置中大量小字符串不再逐个malloc
+	json::storage_ptr arena = json::make_shared_resource<json::monotonic_resource>(text.size() * 2 + 4096);
+	ConfigFormat format = BinaryConfigCodec::Detect(text.data(), text.size());
+	if (format != ConfigFormat::JSON) {
+		// 二进制配置直接解码到内存池中
+		document->reset(new json::value(arena));
+		std::string error;
+		if (!BinaryConfigCodec::Decode(format, text.data(), text.size(), document->get(), &error)) {
+			SetError(error);
 			return false;
 		}
+		return true;
+	}
+	try {
+		document->reset(new json::value(json::parse(text, arena)));
+	} catch (const std::exception& e) {
+		SetError("JSON parsing error: " + std::string(e.what()));
+		return false;
+	}
+	return true;
+}
 
-		std::ifstream file(filename.string());
-		if (!file.is_open()) {
-			SetError("Cannot open config file: " + filename.string());
+bool ConfigParser::ResolveImports(json::value* document, const boost::filesystem::path& base_directory) {
+	imported_files_.clear();
+	if (!document->is_object()) {
+		return true;
+	}
+
+	json::object& root = document->as_object();
+	auto imports = root.find("imports");
+	if (imports == root.end()) {
+		return true;
+	}
+	if (!imports->value().is_array()) {
+		SetError("'imports' must be an array of file paths");
+		return false;
+	}
+
+	std::vector<std::string> import_stack;
+	return MergeImports(&root, JsonArrayToStringVector(imports->value()), base_directory, &import_stack);
+}
+
+bool ConfigParser::MergeImports(json::object* target, const std::vector<std::string>& imports,
+								const boost::filesystem::path& base_directory, std::vector<std::string>* import_stack) {
+	// 合并时只补充target中没有的项，从后往前处理使后面的导入优先
+	for (auto it = imports.rbegin(); it != imports.rend(); ++it) {
+		boost::filesystem::path import_path(*it);
+		if (import_path.is_relative()) {
+			import_path = boost::filesystem::absolute(base_directory) / import_path;
+		}
+		boost::system::error_code ec;
+		std::string path = boost::filesystem::canonical(import_path, ec).string();
+		if (ec) {
+			SetError("Import file does not exist: " + import_path.string());
+			return false;
+		}
+		if (std::find(import_stack->begin(), import_stack->end(), path) != import_stack->end()) {
+			SetError("Circular import: " + path);
 			return false;
 		}
 
-		std::stringstream buffer;
-		buffer << file.rdbuf();
-
-		json::value json;
-		try {
-			json = json::parse(buffer.str());
-		} catch (const std::exception& e) {
-			SetError("JSON parsing error: " + std::string(e.what()));
+		std::string error;
+		ImportCache::Document imported = ImportCache::Instance().Get(path, &error);
+		if (!imported) {
+			SetError(error);
 			return false;
 		}
+		imported_files_[path] = imported->fingerprint;
+
+		const json::object& source = imported->value.as_object();
+		MergeImportedSections(target, source);
 
-		std::map<std::string, std::string> variables;
-		CodeGenConfig::LoadVariables(json, variables);
-		std::string strbuffer = buffer.str();
-		std::cout << "variables.size()" << variables.size() << std::endl;
-		if (variables.size()) {
-			ReplaceBufferByVariables(strbuffer, variables);
-			try {
-				json = json::parse(strbuffer);
-			} catch (const std::exception& e) {
-				SetError("JSON2 parsing error: " + std::string(e.what()));
+		auto nested = source.find("imports");
+		if (nested != source.end() && nested->value().is_array()) {
+			import_stack->push_back(path);
+			bool merged = MergeImports(target, JsonArrayToStringVector(nested->value()),
+									   boost::filesystem::path(path).parent_path(), import_stack);
+			import_stack->pop_back();
+			if (!merged) {
 				return false;
 			}
 		}
-		return LoadFromJson(json);
-
-	} catch (const std::exception& e) {
-		SetError("File loading error: " + std::string(e.what()));
-		return false;
 	}
+	return true;
 }
 
-bool ConfigParser::LoadFromString(const std::string& json_str) {
-	try {
-		json::value json = json::parse(json_str);
-		return LoadFromJson(json);
-	} catch (const std::exception& e) {
-		SetError("JSON parsing error: " + std::string(e.what()));
-		return false;
+void ConfigParser::MergeImportedSections(json::object* target, const json::object& source) {
+	// 对象中的项按名称补充，值拷贝到target的内存池中
+	static const char* kObjectSections[] = {"variables", "code_templates"};
+	for (const char* section : kObjectSections) {
+		auto from = source.find(section);
+		if (from == source.end() || !from->value().is_object()) {
+			continue;
+		}
+		json::value& to = (*target)[section];
+		if (!to.is_object()) {
+			to = json::object(target->storage());
+		}
+		json::object& to_object = to.as_object();
+		for (const auto& item : from->value().as_object()) {
+			if (!to_object.contains(item.key())) {
+				to_object.emplace(item.key(), item.value());
+			}
+		}
+	}
+
+	// 导入的公共包含排在前面，已存在的不重复添加
+	auto includes = source.find("common_includes");
+	if (includes != source.end() && includes->value().is_array()) {
+		json::value& to = (*target)["common_includes"];
+		if (!to.is_array()) {
+			to = json::array(target->storage());
+		}
+		json::array merged(target->storage());
+		for (const auto& include : includes->value().as_array()) {
+			if (std::find(to.as_array().begin(), to.as_array().end(), include) == to.as_array().end() &&
+					std::find(merged.begin(), merged.end(), include) == merged.end()) {
+				merged.push_back(include);
+			}
+		}
+		for (const auto& include : to.as_array()) {
+			merged.push_back(include);
+		}
+		to = std::move(merged);
 	}
 }
 
 bool ConfigParser::LoadFromJson(const json::value& json) {
 	try {
 		project_config_ = CodeGenConfig::ProjectConfig::FromJson(json);
-		BuildVariableMap();
+		if (!BuildVariableMap() || !CompileTemplates()) {
+			return false;
+		}
 
-		if (!ValidateConfig()) {
+		if (validate_on_load_ && !ValidateConfig()) {
 			return false;
 		}
 
@@ -420,121 +626,146 @@ bool ConfigParser::LoadFromJson(const json::value& json) {
 }
 
 std::string ConfigParser::ReplaceVariables(const std::string& text) const {
-	std::string result = text;
+	// 单遍扫描，按名称查找变量表
+	std::string result;
+	VariableResolver::ExpandText(text, variable_table_, &result);
+	return result;
+}
 
-	//for (const auto& [key, value] : variables_) {
-	for (const auto& iter : variables_) {
-		const std::string& key = iter.first;
-		const std::string& value = iter.second;
-		std::string placeholder = "${" + key + "}";
-		size_t pos = 0;
-		while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-			result.replace(pos, placeholder.length(), value);
-			pos += value.length();
+bool ConfigParser::SubstituteVariables(json::value* json, VariableResolver* resolver) {
+	std::vector<json::value*> pending(1, json);
+	std::string replaced;
+	while (!pending.empty()) {
+		json::value* value = pending.back();
+		pending.pop_back();
+
+		if (value->is_string()) {
+			json::string& str = value->as_string();
+			boost::string_view text(str.data(), str.size());
+			if (text.find("${") == boost::string_view::npos) {
+				continue;
+			}
+			replaced.clear();
+			resolver->Expand(text, &replaced);
+			str.assign(replaced.data(), replaced.size());
+		} else if (value->is_array()) {
+			for (auto& element : value->as_array()) {
+				pending.push_back(&element);
+			}
+		} else if (value->is_object()) {
+			for (auto& iter : value->as_object()) {
+				// 代码模板在展开时才替换，{{#each}}中的字段不会被同名的项目变量覆盖
+				if (value == json && iter.key() == "code_templates") {
+					continue;
+				}
+				pending.push_back(&iter.value());
+			}
 		}
 	}
 
-	// 替换系统变量
-	auto replace_system_var = [&](const std::string& placeholder, const std::string& value) {
-		size_t pos = 0;
-		while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-			result.replace(pos, placeholder.length(), value);
-			pos += value.length();
-		}
-	};
-
-	replace_system_var("${PROJECT_NAME}", project_config_.name);
-	replace_system_var("${PROJECT_VERSION}", project_config_.version);
-	replace_system_var("${OUTPUT_DIR}", project_config_.output_dir);
-
-	return result;
+	if (resolver->HasError()) {
+		SetError("Circular variable reference: " + resolver->GetError());
+		return false;
+	}
+	return true;
 }
 
-void ConfigParser::ReplaceBufferByVariables(std::string& strjson, std::map<std::string, std::string>& variables) {
-	for (const auto& iter : variables) {
-		const std::string& key = iter.first;
-		const std::string& value = iter.second;
-		std::string placeholder = "${" + key + "}";
-		size_t pos = 0;
-		while ((pos = strjson.find(placeholder, pos)) != std::string::npos) {
-			strjson.replace(pos, placeholder.length(), value);
-			pos += value.length();
-		}
+std::string ConfigParser::GetTemplate(boost::string_view name) const {
+	auto native_it = native_templates_.find(name);
+	if (native_it != native_templates_.end()) {
+		std::string result;
+		native_it->second({&variable_table_}, &result);
+		return result;
 	}
-}
 
-std::string ConfigParser::GetTemplate(const std::string& name) const {
-	auto it = project_config_.code_templates.find(name);
-	if (it != project_config_.code_templates.end()) {
-		return ProcessTemplate(it->second);
+	const CompiledTemplate* compiled = GetCompiledTemplate(name);
+	if (compiled) {
+		return compiled->Render({&variable_table_}, &project_config_.structured_variables);
 	}
 	return "";
 }
 
+const CompiledTemplate* ConfigParser::GetCompiledTemplate(boost::string_view name) const {
+	auto it = compiled_templates_.find(name);
+	return it != compiled_templates_.end() ? &it->second : nullptr;
+}
+
 std::string ConfigParser::ApplyTemplate(const std::string& template_name, 
 			const std::map<std::string, std::string>& variables) const {
-	std::string template_content = GetTemplate(template_name);
-	if (template_content.empty()) {
+	const CompiledTemplate* compiled = GetCompiledTemplate(template_name);
+	if (!compiled || compiled->Empty()) {
 		return "";
 	}
 
-	std::string result = template_content;
-
-	// 替换传入的变量
-	//for (const auto& [key, value] : variables) {
-	for (const auto& iter : variables) {
-		const std::string& key = iter.first;
-		const std::string& value = iter.second;
-		std::string placeholder = "${" + key + "}";
-		size_t pos = 0;
-		while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-			result.replace(pos, placeholder.length(), value);
-			pos += value.length();
-		}
+	// 项目变量优先，其次是传入的变量
+	VariableTable extra(variables);
+	auto native_it = native_templates_.find(template_name);
+	if (native_it != native_templates_.end()) {
+		std::string result;
+		native_it->second({&variable_table_, &extra}, &result);
+		return result;
 	}
-
-	return result;
+	return compiled->Render({&variable_table_, &extra}, &project_config_.structured_variables);
 }
 
 bool ConfigParser::ValidateConfig() const {
-	if (project_config_.name.empty()) {
-		SetError("Project name is required");
-		return false;
+	std::vector<ConfigDiagnostic> diagnostics;
+	return ValidateConfig(&diagnostics);
+}
+
+bool ConfigParser::ValidateConfig(std::vector<ConfigDiagnostic>* diagnostics) const {
+	ConfigValidator validator(project_config_);
+	validator.SetVariables(&variable_table_);
+	size_t begin = diagnostics->size();
+	if (validator.Validate(diagnostics)) {
+		return true;
 	}
+	SetError(FormatErrors(*diagnostics, begin));
+	return false;
+}
 
-	if (project_config_.files.empty()) {
-		SetError("At least one file must be specified");
-		return false;
+bool ConfigParser::ValidateFileConfig(const CodeGenConfig::FileConfig& file_config) {
+	ConfigValidator validator(project_config_);
+	validator.SetVariables(&variable_table_);
+	validator.SetReferenceChecker(stream_reference_checker_);
+	if (!stream_outputs_) {
+		stream_outputs_ = std::make_shared<ConfigOutputPaths>();
 	}
+	std::vector<ConfigDiagnostic> diagnostics;
+	if (validator.ValidateFile(file_config, stream_outputs_.get(), &diagnostics)) {
+		return true;
+	}
+	SetError(FormatErrors(diagnostics, 0));
+	return false;
+}
 
-	for (const auto& file_config : project_config_.files) {
-		if (file_config.filename.empty()) {
-			SetError("Filename cannot be empty");
-			return false;
+std::string ConfigParser::FormatErrors(const std::vector<ConfigDiagnostic>& diagnostics, size_t begin) {
+	// 所有错误一次给出，每条一行
+	std::string message;
+	for (size_t i = begin; i < diagnostics.size(); ++i) {
+		if (diagnostics[i].severity != ConfigDiagnostic::Severity::ERROR) {
+			continue;
 		}
-
-		// 检查文件名有效性
-		if (file_config.filename.find("..") != std::string::npos) {
-			SetError("Invalid filename: " + file_config.filename);
-			return false;
+		if (!message.empty()) {
+			message += '\n';
+		}
+		if (!diagnostics[i].location.empty()) {
+			message += diagnostics[i].location;
+			message += ": ";
 		}
+		message += diagnostics[i].message;
 	}
-
-	return true;
+	return message;
 }
 
-bool ConfigParser::SaveToFile(const boost::filesystem::path& filename) const {
+bool ConfigParser::SaveToFile(const boost::filesystem::path& filename, bool pretty) const {
 	try {
-		std::ofstream file(filename.string());
-		if (!file.is_open()) {
-			SetError("Cannot open file for writing: " + filename.string());
+		// 文件打不开时构造函数抛出异常，由下面的catch报告
+		FileOutputStream output(filename);
+		if (!WriteJson(&output, pretty) || !output.Flush()) {
+			SetError("File saving error: cannot write " + filename.string());
 			return false;
 		}
-
-		std::string json_str = ToJsonString(true);
-		file << json_str;
-		file.close();
-
 		return true;
 	} catch (const std::exception& e) {
 		SetError("File saving error: " + std::string(e.what()));
@@ -543,29 +774,78 @@ bool ConfigParser::SaveToFile(const boost::filesystem::path& filename) const {
 }
 
 std::string ConfigParser::ToJsonString(bool pretty) const {
-	json::value json = project_config_.ToJson();
+	std::string result;
+	StringOutputStream output(&result);
+	WriteJson(&output, pretty);
+	return result;
+}
 
-	if (pretty) {
-		//return json::serialize(json, json::serialize_opts{});
-		return json::serialize(json);
-	} else {
-		return json::serialize(json);
+bool ConfigParser::WriteJson(ZeroCopyOutputStream* output, bool pretty) const {
+	JsonWriter writer(output, pretty);
+	project_config_.WriteJson(writer);
+	if (!writer.Flush()) {
+		return false;
 	}
+	return !pretty || output->WriteChar('\n');
 }
 
-void ConfigParser::BuildVariableMap() {
-	variables_ = project_config_.variables;
+bool ConfigParser::BuildVariableMap() {
+	VariableResolver resolver(project_config_.variables);
 
 	// 添加默认变量
-	variables_["PROJECT_NAME"] = project_config_.name;
-	variables_["PROJECT_VERSION"] = project_config_.version;
-	variables_["OUTPUT_DIR"] = project_config_.output_dir;
+	resolver.Define("PROJECT_NAME", project_config_.name);
+	resolver.Define("PROJECT_VERSION", project_config_.version);
+	resolver.Define("OUTPUT_DIR", project_config_.output_dir);
 
 	// 添加时间戳变量
-	std::time_t now = std::time(nullptr);
-	char time_str[100];
-	std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-	variables_["TIMESTAMP"] = time_str;
+	resolver.DefineComputed("TIMESTAMP", []() {
+		std::time_t now = std::time(nullptr);
+		char time_str[100];
+		// 多个项目可能并发加载配置，使用可重入的localtime
+		std::tm local_tm;
+#ifdef _WIN32
+		localtime_s(&local_tm, &now);
+#else
+		localtime_r(&now, &local_tm);
+#endif
+		std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &local_tm);
+		return std::string(time_str);
+	});
+
+	// 渲染时多个线程并发查表，这里一次展开所有变量，引用其他变量的值也已展开
+	variables_.clear();
+	resolver.ResolveAll(&variables_);
+	variable_table_.Assign(variables_);
+	if (resolver.HasError()) {
+		SetError("Circular variable reference: " + resolver.GetError());
+		return false;
+	}
+	return true;
+}
+
+bool ConfigParser::CompileTemplates() {
+	compiled_templates_.clear();
+	FindNativeTemplates();
+	for (const auto& iter : project_config_.code_templates) {
+		CompiledTemplate compiled(iter.second);
+		if (!compiled.Ok()) {
+			SetError("Template '" + iter.first + "' compile error: " + compiled.GetError());
+			return false;
+		}
+		compiled_templates_.emplace(iter.first, std::move(compiled));
+	}
+	return true;
+}
+
+void ConfigParser::FindNativeTemplates() {
+	// 插件可能在两次加载之间注册，每次加载都重新查找
+	native_templates_.clear();
+	for (const auto& iter : project_config_.code_templates) {
+		NativeTemplateRenderer native = NativeTemplateRegistry::Instance().Find(iter.first, iter.second);
+		if (native) {
+			native_templates_[iter.first] = native;
+		}
+	}
 }
 
 std::string ConfigParser::ProcessTemplate(const std::string& template_text) const {
@@ -577,14 +857,20 @@ void ConfigParser::SetError(const std::string& error) {
 }
 
 // JSON辅助方法实现
+std::string ConfigParser::JsonToString(const json::value& value) {
+	const json::string& str = value.as_string();
+	return std::string(str.data(), str.size());
+}
+
 std::vector<std::string> ConfigParser::JsonArrayToStringVector(const json::value& array) {
 	std::vector<std::string> result;
 
 	if (array.is_array()) {
 		const json::array& arr = array.as_array();
+		result.reserve(arr.size());
 		for (const auto& item : arr) {
 			if (item.is_string()) {
-				result.push_back(item.as_string().c_str());
+				result.push_back(JsonToString(item));
 			}
 		}
 	}
@@ -606,7 +892,7 @@ std::map<std::string, std::string> ConfigParser::JsonObjectToStringMap(const jso
 		*/
 		for (const auto& iter : obj) {
 			if (iter.value().is_string()) {
-				result[iter.key()] = iter.value().as_string().c_str();
+				result[iter.key()] = ConfigParser::JsonToString(iter.value());
 			}
 		}
 	}
@@ -614,6 +900,28 @@ std::map<std::string, std::string> ConfigParser::JsonObjectToStringMap(const jso
 	return result;
 }
 
+void ConfigParser::JsonObjectToStringMap(const json::value& object, std::map<std::string, std::string>* map) {
+	if (object.is_object()) {
+		for (const auto& iter : object.as_object()) {
+			if (iter.value().is_string()) {
+				(*map)[iter.key()] = ConfigParser::JsonToString(iter.value());
+			}
+		}
+	}
+}
+
+void ConfigParser::JsonObjectToStringMap(const json::value& object, StringMap* map) {
+	if (object.is_object()) {
+		const json::object& obj = object.as_object();
+		map->reserve(map->size() + obj.size());
+		for (const auto& iter : obj) {
+			if (iter.value().is_string()) {
+				(*map)[boost::string_view(iter.key().data(), iter.key().size())] = ConfigParser::JsonToString(iter.value());
+			}
+		}
+	}
+}
+
 json::value ConfigParser::StringVectorToJsonArray(const std::vector<std::string>& vec) {
 	json::array result;
 	for (const auto& str : vec) {
@@ -632,4 +940,13 @@ json::value ConfigParser::StringMapToJsonObject(const std::map<std::string, std:
 	return result;
 }
 
+json::value ConfigParser::StringMapToJsonObject(const StringMap& map) {
+	json::object result;
+	result.reserve(map.size());
+	for (const auto& iter : map) {
+		result[iter.first] = iter.second;
+	}
+	return result;
+}
+
 } // namespace code_generator
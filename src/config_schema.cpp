@@ -0,0 +1,536 @@
+#include "code_generator/config_schema.h"
+#include "code_generator/file_streams.h"
+#include <boost/format.hpp>
+#include <utility>
+
+namespace code_generator {
+
+namespace {
+
+typedef ConfigSchemaField::Kind Kind;
+
+ConfigSchemaField Field(const char* key, const char* member, Kind kind, const char* element = nullptr,
+						bool omit_empty = false, bool read_only = false) {
+	ConfigSchemaField field = { key, member, kind, element, omit_empty, read_only };
+	return field;
+}
+
+// 给每行加上depth层缩进后追加到body
+void AppendLines(const std::vector<std::string>& lines, int depth, std::string* body) {
+	for (const auto& line : lines) {
+		body->append(depth, '\t');
+		body->append(line);
+		body->push_back('\n');
+	}
+}
+
+// 除简写字段外其余字段都等于默认值的条件
+std::string ShorthandCondition(const ConfigSchemaStruct& config) {
+	std::string condition;
+	for (const auto& field : config.fields) {
+		if (field.read_only || field.member == boost::string_view(config.shorthand)) {
+			continue;
+		}
+		if (!condition.empty()) {
+			condition += " && ";
+		}
+		condition += std::string(field.member) + " == defaults." + field.member;
+	}
+	return condition;
+}
+
+// 给每行加上一层缩进
+std::string IndentLines(const std::string& text) {
+	std::string indented;
+	size_t begin = 0;
+	while (begin < text.size()) {
+		size_t end = text.find('\n', begin) + 1;
+		indented += "\t" + text.substr(begin, end - begin);
+		begin = end;
+	}
+	return indented;
+}
+
+} // namespace
+
+const std::vector<ConfigSchemaStruct>& GetConfigSchema() {
+	// 字段顺序即ToJson的输出顺序
+	static const std::vector<ConfigSchemaStruct> schema = {
+		{ "FunctionConfig", nullptr, {
+			Field("name", "name", Kind::STRING),
+			Field("return_type", "return_type", Kind::STRING),
+			Field("body", "body", Kind::STRING),
+			Field("access", "access", Kind::STRING),
+			Field("virtual", "is_virtual", Kind::BOOL),
+			Field("pure_virtual", "is_pure_virtual", Kind::BOOL),
+			Field("const", "is_const", Kind::BOOL),
+			Field("static", "is_static", Kind::BOOL),
+			Field("templates", "templates", Kind::STRING_ARRAY),
+			Field("parameters", "parameters", Kind::PARAMETERS),
+		} },
+		{ "MemberConfig", nullptr, {
+			Field("name", "name", Kind::STRING),
+			Field("type", "type", Kind::STRING),
+			Field("initializer", "initializer", Kind::STRING),
+			Field("access", "access", Kind::STRING),
+			Field("comment", "comment", Kind::STRING),
+		} },
+		{ "ClassConfig", nullptr, {
+			Field("name", "name", Kind::STRING),
+			Field("base_classes", "base_classes", Kind::STRING_ARRAY),
+			Field("templates", "templates", Kind::STRING_ARRAY),
+			Field("metadata", "metadata", Kind::STRING_MAP),
+			Field("functions", "functions", Kind::STRUCT_ARRAY, "FunctionConfig"),
+			Field("members", "members", Kind::STRUCT_ARRAY, "MemberConfig"),
+		} },
+		{ "SnippetConfig", "reference", {
+			Field("reference", "reference", Kind::STRING),
+			Field("anchor", "anchor", Kind::STRING),
+			Field("target", "target", Kind::STRING),
+		} },
+		{ "FileConfig", nullptr, {
+			Field("filename", "filename", Kind::STRING),
+			Field("type", "type", Kind::STRING),
+			Field("source_filename", "source_filename", Kind::STRING),
+			Field("includes", "includes", Kind::STRING_ARRAY),
+			Field("namespaces", "namespaces", Kind::STRING_ARRAY),
+			Field("copy_files", "copy_files", Kind::STRING_ARRAY),
+			Field("insert_snippets", "insert_snippets", Kind::STRUCT_ARRAY, "SnippetConfig"),
+			Field("classes", "classes", Kind::STRUCT_ARRAY, "ClassConfig"),
+			Field("functions", "functions", Kind::STRUCT_ARRAY, "FunctionConfig"),
+			Field("globals", "globals", Kind::STRUCT_ARRAY, "MemberConfig"),
+			Field("templates", "templates", Kind::STRING_MAP),
+		} },
+		{ "ProjectConfig", nullptr, {
+			Field("name", "name", Kind::STRING),
+			Field("version", "version", Kind::STRING),
+			Field("output_dir", "output_dir", Kind::STRING),
+			// 加载时已合并到variables等字段中，保存的配置不再引用导入文件
+			Field("imports", "imports", Kind::STRING_ARRAY, nullptr, true, true),
+			Field("common_includes", "common_includes", Kind::STRING_ARRAY),
+			Field("files", "files", Kind::STRUCT_ARRAY, "FileConfig"),
+			Field("variables", "variables", Kind::VARIABLES, "structured_variables"),
+			Field("code_templates", "code_templates", Kind::STRING_MAP),
+		} },
+	};
+	return schema;
+}
+
+uint32_t ConfigSchemaCompiler::KeyHash(boost::string_view key) {
+	uint32_t hash = 2166136261u;
+	for (char c : key) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	return hash;
+}
+
+bool ConfigSchemaCompiler::WriteFile(const boost::filesystem::path& path, std::string* error) const {
+	// 文件打不开时FileOutputStream的构造函数抛出异常
+	boost::shared_ptr<FileOutputStream> output;
+	try {
+		if (path.has_parent_path()) {
+			boost::filesystem::create_directories(path.parent_path());
+		}
+		output.reset(new FileOutputStream(path));
+	} catch (const std::exception& e) {
+		*error = e.what();
+		return false;
+	}
+
+	{
+		// 与config_parser.cpp一致使用tab缩进
+		CppGeneratorOptions options;
+		options.indent_style = Formatter::IndentStyle::TABS;
+		options.generate_comments = false;
+		options.use_pragma_once = false;
+		CppGenerator generator(output, options);
+		WriteSource(generator);
+	}
+	if (!output->Flush()) {
+		*error = "Cannot write " + path.string();
+		return false;
+	}
+	return true;
+}
+
+void ConfigSchemaCompiler::WriteSource(CppGenerator& generator) const {
+	Formatter& formatter = generator.GetFormatter();
+	formatter.AddComment("由cppcodegen --generate-config-json根据src/config_schema.cpp中的描述生成，请勿手工修改");
+	formatter.Include("\"code_generator/config_parser.h\"");
+	formatter.Include("\"code_generator/json_writer.h\"");
+	formatter.Include("<cstdint>");
+	formatter.EndLine();
+	formatter.AddLine("namespace code_generator {");
+	formatter.EndLine();
+
+	formatter.AddLine("namespace {");
+	formatter.EndLine();
+	formatter.AddComment("FNV-1a，与ConfigSchemaCompiler::KeyHash一致，case中的常量由它在生成时算出");
+	SymbolTable& symbols = generator.GetSymbols();
+	CppFunction hash;
+	hash.return_type = symbols.Intern("uint32_t");
+	hash.name = "ConfigKeyHash";
+	hash.AddParameter(symbols.Intern("json::string_view"), "key");
+	hash.body = "uint32_t hash = 2166136261u;\n"
+				"for (char c : key) {\n"
+				"\thash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;\n"
+				"}\n"
+				"return hash;";
+	generator.GenerateFunctionImplementation(hash);
+	formatter.EndLine();
+	formatter.AddLine("} // namespace");
+
+	for (const auto& config : schema_) {
+		std::string class_name = std::string("CodeGenConfig::") + config.name;
+		formatter.EndLine();
+		generator.GenerateFunctionImplementation(BuildFromJson(config, symbols), class_name);
+		formatter.EndLine();
+		generator.GenerateFunctionImplementation(BuildToJson(config, symbols), class_name);
+		formatter.EndLine();
+		generator.GenerateFunctionImplementation(BuildWriteJson(config, symbols), class_name);
+	}
+
+	formatter.EndLine();
+	formatter.AddLine("} // namespace code_generator");
+}
+
+CppFunction ConfigSchemaCompiler::BuildFromJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const {
+	CppFunction function;
+	function.return_type = symbols.Intern(std::string("CodeGenConfig::") + config.name);
+	function.name = "FromJson";
+	CppParameter& json = function.AddParameter(symbols.Intern("json::value"), "json");
+	json.type.is_const = true;
+	json.type.is_reference = true;
+
+	// 在局部字符串中拼接，模型的body在使用内存池时是pmr字符串
+	std::string body;
+	body = std::string(config.name) + " config;\n";
+	if (config.shorthand) {
+		AppendLines({
+			"if (json.is_string()) {",
+			std::string("\tconfig.") + config.shorthand + " = ConfigParser::JsonToString(json);",
+			"\treturn config;",
+			"}"
+		}, 0, &body);
+	}
+	AppendLines({
+		"const json::object* obj = json.if_object();",
+		"if (!obj) {",
+		"\treturn config;",
+		"}",
+		"",
+		"// 一次遍历对象成员，按键的哈希值分派到字段",
+		"for (const auto& iter : *obj) {",
+		"\tconst json::string_view key = iter.key();",
+		"\tconst json::value& value = iter.value();",
+		"\tswitch (ConfigKeyHash(key)) {"
+	}, 0, &body);
+
+	// 哈希值相同的键放在同一个case中依次比较
+	std::vector<std::pair<uint32_t, std::vector<const ConfigSchemaField*>>> cases;
+	for (const auto& field : config.fields) {
+		uint32_t hash = KeyHash(field.key);
+		size_t index = 0;
+		while (index < cases.size() && cases[index].first != hash) {
+			++index;
+		}
+		if (index == cases.size()) {
+			cases.push_back(std::make_pair(hash, std::vector<const ConfigSchemaField*>()));
+		}
+		cases[index].second.push_back(&field);
+	}
+
+	for (const auto& iter : cases) {
+		AppendLines({ boost::str(boost::format("case 0x%08xu:") % iter.first) }, 1, &body);
+		for (const ConfigSchemaField* field : iter.second) {
+			AppendLines({ std::string("if (key == \"") + field->key + "\" && value." + TypeCheck(field->kind) + "()) {" },
+						2, &body);
+			AppendFieldRead(*field, &body);
+			AppendLines({ "}" }, 2, &body);
+		}
+		AppendLines({ "break;" }, 2, &body);
+	}
+
+	AppendLines({
+		"default:",
+		"\tbreak;",
+		"}"
+	}, 1, &body);
+	AppendLines({
+		"}",
+		"",
+		"return config;"
+	}, 0, &body);
+	function.body = std::move(body);
+	return function;
+}
+
+CppFunction ConfigSchemaCompiler::BuildToJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const {
+	CppFunction function;
+	function.return_type = symbols.Intern("json::value");
+	function.name = "ToJson";
+	function.is_const = true;
+
+	std::string body;
+	if (config.shorthand) {
+		// 其余字段均为默认值时输出为字符串，保持旧格式
+		AppendLines({
+			std::string("const ") + config.name + " defaults;",
+			"if (" + ShorthandCondition(config) + ") {",
+			std::string("\treturn json::value(") + config.shorthand + ");",
+			"}",
+			""
+		}, 0, &body);
+	}
+
+	size_t written = 0;
+	for (const auto& field : config.fields) {
+		if (!field.read_only) {
+			++written;
+		}
+	}
+	AppendLines({
+		"json::object obj;",
+		"obj.reserve(" + std::to_string(written) + ");"
+	}, 0, &body);
+	for (const auto& field : config.fields) {
+		if (field.read_only) {
+			continue;
+		}
+		std::string write;
+		AppendFieldWrite(field, &write);
+		if (field.omit_empty) {
+			AppendLines({ std::string("if (!") + field.member + ".empty()) {" }, 0, &body);
+			body += IndentLines(write);
+			AppendLines({ "}" }, 0, &body);
+		} else {
+			body += write;
+		}
+	}
+	body += "return obj;";
+	function.body = std::move(body);
+	return function;
+}
+
+CppFunction ConfigSchemaCompiler::BuildWriteJson(const ConfigSchemaStruct& config, SymbolTable& symbols) const {
+	CppFunction function;
+	function.return_type = symbols.Intern("void");
+	function.name = "WriteJson";
+	function.is_const = true;
+	CppParameter& writer = function.AddParameter(symbols.Intern("JsonWriter"), "writer");
+	writer.type.is_reference = true;
+
+	std::string body;
+	if (config.shorthand) {
+		AppendLines({
+			std::string("const ") + config.name + " defaults;",
+			"if (" + ShorthandCondition(config) + ") {",
+			std::string("\twriter.String(") + config.shorthand + ");",
+			"\treturn;",
+			"}",
+			""
+		}, 0, &body);
+	}
+
+	AppendLines({ "writer.BeginObject();" }, 0, &body);
+	for (const auto& field : config.fields) {
+		if (field.read_only) {
+			continue;
+		}
+		std::string write;
+		AppendFieldStream(field, &write);
+		if (field.omit_empty) {
+			AppendLines({ std::string("if (!") + field.member + ".empty()) {" }, 0, &body);
+			body += IndentLines(write);
+			AppendLines({ "}" }, 0, &body);
+		} else {
+			body += write;
+		}
+	}
+	body += "writer.EndObject();";
+	function.body = std::move(body);
+	return function;
+}
+
+void ConfigSchemaCompiler::AppendFieldRead(const ConfigSchemaField& field, std::string* body) {
+	std::string member = std::string("config.") + field.member;
+	switch (field.kind) {
+	case Kind::STRING:
+		AppendLines({ member + " = ConfigParser::JsonToString(value);" }, 3, body);
+		break;
+	case Kind::BOOL:
+		AppendLines({ member + " = value.as_bool();" }, 3, body);
+		break;
+	case Kind::STRING_ARRAY:
+		AppendLines({ member + " = ConfigParser::JsonArrayToStringVector(value);" }, 3, body);
+		break;
+	case Kind::STRING_MAP:
+		AppendLines({ "ConfigParser::JsonObjectToStringMap(value, &" + member + ");" }, 3, body);
+		break;
+	case Kind::STRUCT_ARRAY:
+		AppendLines({
+			"const json::array& items = value.as_array();",
+			member + ".reserve(items.size());",
+			"for (const auto& item : items) {",
+			"\t" + member + ".push_back(" + field.element + "::FromJson(item));",
+			"}"
+		}, 3, body);
+		break;
+	case Kind::PARAMETERS:
+		// 类型和名称都不为空的参数才保留
+		AppendLines({
+			"for (const auto& item : value.as_array()) {",
+			"\tconst json::object* parameter = item.if_object();",
+			"\tif (!parameter) {",
+			"\t\tcontinue;",
+			"\t}",
+			"\tstd::string type, name;",
+			"\tfor (const auto& attribute : *parameter) {",
+			"\t\tif (!attribute.value().is_string()) {",
+			"\t\t\tcontinue;",
+			"\t\t}",
+			"\t\tif (attribute.key() == \"type\") {",
+			"\t\t\ttype = ConfigParser::JsonToString(attribute.value());",
+			"\t\t} else if (attribute.key() == \"name\") {",
+			"\t\t\tname = ConfigParser::JsonToString(attribute.value());",
+			"\t\t}",
+			"\t}",
+			"\tif (!type.empty() && !name.empty()) {",
+			"\t\t" + member + ".emplace_back(std::move(type), std::move(name));",
+			"\t}",
+			"}"
+		}, 3, body);
+		break;
+	case Kind::VARIABLES:
+		AppendLines({
+			"ConfigParser::JsonObjectToStringMap(value, &" + member + ");",
+			"for (const auto& variable : value.as_object()) {",
+			"\tif (!variable.value().is_string()) {",
+			std::string("\t\tconfig.") + field.element + ".emplace(variable.key(), variable.value());",
+			"\t}",
+			"}"
+		}, 3, body);
+		break;
+	}
+}
+
+void ConfigSchemaCompiler::AppendFieldWrite(const ConfigSchemaField& field, std::string* body) {
+	std::string member = field.member;
+	std::string target = std::string("obj[\"") + field.key + "\"] = ";
+	switch (field.kind) {
+	case Kind::STRING:
+	case Kind::BOOL:
+		AppendLines({ target + member + ";" }, 0, body);
+		break;
+	case Kind::STRING_ARRAY:
+		AppendLines({ target + "ConfigParser::StringVectorToJsonArray(" + member + ");" }, 0, body);
+		break;
+	case Kind::STRING_MAP:
+		AppendLines({ target + "ConfigParser::StringMapToJsonObject(" + member + ");" }, 0, body);
+		break;
+	case Kind::STRUCT_ARRAY:
+		AppendLines({
+			"json::array " + member + "_array;",
+			member + "_array.reserve(" + member + ".size());",
+			"for (const auto& item : " + member + ") {",
+			"\t" + member + "_array.push_back(item.ToJson());",
+			"}",
+			target + "std::move(" + member + "_array);"
+		}, 0, body);
+		break;
+	case Kind::PARAMETERS:
+		AppendLines({
+			"json::array " + member + "_array;",
+			member + "_array.reserve(" + member + ".size());",
+			"for (const auto& item : " + member + ") {",
+			"\tjson::object parameter;",
+			"\tparameter[\"type\"] = item.first;",
+			"\tparameter[\"name\"] = item.second;",
+			"\t" + member + "_array.push_back(std::move(parameter));",
+			"}",
+			target + "std::move(" + member + "_array);"
+		}, 0, body);
+		break;
+	case Kind::VARIABLES:
+		AppendLines({
+			"json::object " + member + "_object = ConfigParser::StringMapToJsonObject(" + member + ").as_object();",
+			std::string("for (const auto& item : ") + field.element + ") {",
+			"\t" + member + "_object.emplace(item.key(), item.value());",
+			"}",
+			target + "std::move(" + member + "_object);"
+		}, 0, body);
+		break;
+	}
+}
+
+void ConfigSchemaCompiler::AppendFieldStream(const ConfigSchemaField& field, std::string* body) {
+	std::string member = field.member;
+	AppendLines({ std::string("writer.Key(\"") + field.key + "\");" }, 0, body);
+	switch (field.kind) {
+	case Kind::STRING:
+		AppendLines({ "writer.String(" + member + ");" }, 0, body);
+		break;
+	case Kind::BOOL:
+		AppendLines({ "writer.Bool(" + member + ");" }, 0, body);
+		break;
+	case Kind::STRING_ARRAY:
+		AppendLines({ "writer.StringArray(" + member + ");" }, 0, body);
+		break;
+	case Kind::STRING_MAP:
+		AppendLines({ "writer.StringObject(" + member + ");" }, 0, body);
+		break;
+	case Kind::STRUCT_ARRAY:
+		AppendLines({
+			"writer.BeginArray();",
+			"for (const auto& item : " + member + ") {",
+			"\titem.WriteJson(writer);",
+			"}",
+			"writer.EndArray();"
+		}, 0, body);
+		break;
+	case Kind::PARAMETERS:
+		AppendLines({
+			"writer.BeginArray();",
+			"for (const auto& item : " + member + ") {",
+			"\twriter.BeginObject();",
+			"\twriter.Key(\"type\");",
+			"\twriter.String(item.first);",
+			"\twriter.Key(\"name\");",
+			"\twriter.String(item.second);",
+			"\twriter.EndObject();",
+			"}",
+			"writer.EndArray();"
+		}, 0, body);
+		break;
+	case Kind::VARIABLES:
+		AppendLines({
+			"writer.BeginObject();",
+			"for (const auto& item : " + member + ") {",
+			"\twriter.Key(item.first);",
+			"\twriter.String(item.second);",
+			"}",
+			std::string("for (const auto& item : ") + field.element + ") {",
+			"\twriter.Key(item.key().data(), item.key().size());",
+			"\twriter.Value(item.value());",
+			"}",
+			"writer.EndObject();"
+		}, 0, body);
+		break;
+	}
+}
+
+const char* ConfigSchemaCompiler::TypeCheck(Kind kind) {
+	switch (kind) {
+	case Kind::STRING:
+		return "is_string";
+	case Kind::BOOL:
+		return "is_bool";
+	case Kind::STRING_MAP:
+	case Kind::VARIABLES:
+		return "is_object";
+	default:
+		return "is_array";
+	}
+}
+
+} // namespace code_generator
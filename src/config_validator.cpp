@@ -0,0 +1,408 @@
+#include "code_generator/config_validator.h"
+#include "code_generator/variable_resolver.h"
+#include <boost/filesystem.hpp>
+#include <set>
+#include <unordered_map>
+
+namespace code_generator {
+
+namespace {
+
+// pos指向"${"之后，返回与之匹配的'}'的位置，名称中可以嵌套${...}
+size_t FindPlaceholderEnd(const std::string& text, size_t pos) {
+	int depth = 1;
+	while (pos < text.size()) {
+		if (text[pos] == '$' && pos + 1 < text.size() && text[pos + 1] == '{') {
+			++depth;
+			pos += 2;
+			continue;
+		}
+		if (text[pos] == '}' && --depth == 0) {
+			return pos;
+		}
+		++pos;
+	}
+	return std::string::npos;
+}
+
+void AddDiagnostic(ConfigDiagnostic::Severity severity, const std::string& location, const std::string& message,
+				   std::vector<ConfigDiagnostic>* diagnostics) {
+	ConfigDiagnostic diagnostic;
+	diagnostic.severity = severity;
+	diagnostic.location = location;
+	diagnostic.message = message;
+	diagnostics->push_back(std::move(diagnostic));
+}
+
+void AddError(const std::string& location, const std::string& message, std::vector<ConfigDiagnostic>* diagnostics) {
+	AddDiagnostic(ConfigDiagnostic::Severity::ERROR, location, message, diagnostics);
+}
+
+// 名称为空时位置中仍能看出是哪一类元素
+std::string NamedLocation(const std::string& location, const char* kind, const std::string& name) {
+	return location + ": " + kind + " " + (name.empty() ? "<unnamed>" : name);
+}
+
+std::string WithReason(const std::string& message, const std::string& reason) {
+	return reason.empty() ? message : message + " (" + reason + ")";
+}
+
+} // namespace
+
+std::string ConfigDiagnostic::ToString() const {
+	std::string result = severity == Severity::ERROR ? "error: " : "warning: ";
+	if (!location.empty()) {
+		result += location;
+		result += ": ";
+	}
+	result += message;
+	return result;
+}
+
+bool ConfigValidator::Validate(std::vector<ConfigDiagnostic>* diagnostics) const {
+	size_t begin = diagnostics->size();
+
+	if (config_.name.empty()) {
+		AddError("project", "Project name is required", diagnostics);
+	}
+	if (config_.files.empty()) {
+		AddError("project", "At least one file must be specified", diagnostics);
+	}
+	CheckVariables(config_.output_dir, "project: output_dir", diagnostics);
+	for (const auto& include : config_.common_includes) {
+		CheckVariables(include, "project: common_includes", diagnostics);
+	}
+
+	// 各文件的结果写入各自的列表，合并后与串行检查的顺序一致
+	const size_t file_count = config_.files.size();
+	std::vector<std::vector<ConfigDiagnostic>> file_diagnostics(file_count);
+	auto check_file = [&](size_t i) {
+		CheckFile(config_.files[i], &file_diagnostics[i]);
+	};
+	if (thread_pool_ && file_count > 1) {
+		thread_pool_->ParallelFor(file_count, check_file);
+	} else {
+		for (size_t i = 0; i < file_count; ++i) {
+			check_file(i);
+		}
+	}
+	for (auto& items : file_diagnostics) {
+		diagnostics->insert(diagnostics->end(), std::make_move_iterator(items.begin()),
+							std::make_move_iterator(items.end()));
+	}
+
+	CheckDuplicateOutputs(diagnostics);
+
+	for (size_t i = begin; i < diagnostics->size(); ++i) {
+		if ((*diagnostics)[i].severity == ConfigDiagnostic::Severity::ERROR) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ConfigValidator::ValidateFile(const CodeGenConfig::FileConfig& file_config,
+								   std::vector<ConfigDiagnostic>* diagnostics) const {
+	std::vector<ConfigDiagnostic> items;
+	CheckFile(file_config, &items);
+	bool ok = !HasErrors(items);
+	diagnostics->insert(diagnostics->end(), std::make_move_iterator(items.begin()),
+						std::make_move_iterator(items.end()));
+	return ok;
+}
+
+bool ConfigValidator::ValidateFile(const CodeGenConfig::FileConfig& file_config, ConfigOutputPaths* outputs,
+								   std::vector<ConfigDiagnostic>* diagnostics) const {
+	std::vector<ConfigDiagnostic> items;
+	CheckFile(file_config, &items);
+	CheckStreamedOutputs(file_config, outputs, &items);
+	bool ok = !HasErrors(items);
+	diagnostics->insert(diagnostics->end(), std::make_move_iterator(items.begin()),
+						std::make_move_iterator(items.end()));
+	return ok;
+}
+
+std::string ConfigValidator::SourceFilename(const CodeGenConfig::FileConfig& file_config) {
+	if (!file_config.source_filename.empty()) {
+		return file_config.source_filename;
+	}
+	return boost::filesystem::path(file_config.filename).replace_extension(".cpp").string();
+}
+
+bool ConfigValidator::HasErrors(const std::vector<ConfigDiagnostic>& diagnostics) {
+	for (const auto& diagnostic : diagnostics) {
+		if (diagnostic.severity == ConfigDiagnostic::Severity::ERROR) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ConfigValidator::PrintReport(const std::vector<ConfigDiagnostic>& diagnostics, std::ostream& out) {
+	for (const auto& diagnostic : diagnostics) {
+		out << diagnostic.ToString() << std::endl;
+	}
+}
+
+void ConfigValidator::CheckFile(const CodeGenConfig::FileConfig& file_config,
+								std::vector<ConfigDiagnostic>* diagnostics) const {
+	const std::string location = file_config.filename.empty() ? "<unnamed file>" : file_config.filename;
+
+	if (file_config.filename.empty()) {
+		AddError(location, "Filename cannot be empty", diagnostics);
+	} else if (file_config.filename.find("..") != std::string::npos) {
+		AddError(location, "Invalid filename: " + file_config.filename, diagnostics);
+	}
+	if (file_config.source_filename.find("..") != std::string::npos) {
+		AddError(location, "Invalid source filename: " + file_config.source_filename, diagnostics);
+	}
+	CheckVariables(file_config.filename, location, diagnostics);
+	CheckVariables(file_config.source_filename, location, diagnostics);
+
+	for (const auto& include : file_config.includes) {
+		CheckVariables(include, location + ": includes", diagnostics);
+	}
+	for (const auto& name : file_config.namespaces) {
+		CheckVariables(name, location + ": namespaces", diagnostics);
+	}
+	for (const auto& class_config : file_config.classes) {
+		CheckClass(class_config, location, diagnostics);
+	}
+	for (const auto& function : file_config.functions) {
+		CheckFunction(function, location, diagnostics);
+	}
+	for (const auto& global : file_config.globals) {
+		CheckMember(global, location, diagnostics);
+	}
+
+	for (const auto& snippet : file_config.insert_snippets) {
+		if (snippet.anchor != "after_includes" && snippet.anchor != "namespace_begin" &&
+			snippet.anchor != "namespace_end" && snippet.anchor != "end_of_file") {
+			AddError(location, "Invalid snippet anchor: " + snippet.anchor, diagnostics);
+		}
+		if (snippet.target != "header" && snippet.target != "source") {
+			AddError(location, "Invalid snippet target: " + snippet.target, diagnostics);
+		}
+		CheckVariables(snippet.reference, location + ": insert_snippets", diagnostics);
+		std::string reason;
+		if (!CheckReference(snippet.reference, &reason)) {
+			AddError(location, WithReason("Unresolved snippet: " + snippet.reference, reason), diagnostics);
+		}
+	}
+
+	for (const auto& copy_file : file_config.copy_files) {
+		CheckVariables(copy_file, location + ": copy_files", diagnostics);
+		if (!reference_checker_) {
+			continue;
+		}
+		// 与生成时一致：先按文件路径复制，失败时再作为代码引用解析
+		boost::system::error_code ec;
+		if (boost::filesystem::is_regular_file(copy_file, ec)) {
+			continue;
+		}
+		std::string reason;
+		if (!CheckReference(copy_file, &reason)) {
+			AddError(location, WithReason("Copy file not found: " + copy_file, reason), diagnostics);
+		}
+	}
+}
+
+void ConfigValidator::CheckClass(const CodeGenConfig::ClassConfig& class_config, const std::string& location,
+								 std::vector<ConfigDiagnostic>* diagnostics) const {
+	const std::string class_location = NamedLocation(location, "class", class_config.name);
+	if (class_config.name.empty()) {
+		AddError(class_location, "Class name cannot be empty", diagnostics);
+	}
+	CheckVariables(class_config.name, class_location, diagnostics);
+	for (const auto& base : class_config.base_classes) {
+		CheckVariables(base, class_location, diagnostics);
+	}
+	for (const auto& name : class_config.templates) {
+		std::string reason;
+		if (!CheckReference(name, &reason)) {
+			AddError(class_location, WithReason("Unknown template: " + name, reason), diagnostics);
+		}
+	}
+	for (const auto& function : class_config.functions) {
+		CheckFunction(function, class_location, diagnostics);
+	}
+	for (const auto& member : class_config.members) {
+		CheckMember(member, class_location, diagnostics);
+	}
+}
+
+void ConfigValidator::CheckFunction(const CodeGenConfig::FunctionConfig& function, const std::string& location,
+									std::vector<ConfigDiagnostic>* diagnostics) const {
+	const std::string function_location = NamedLocation(location, "function", function.name);
+	if (function.name.empty()) {
+		AddError(function_location, "Function name cannot be empty", diagnostics);
+	}
+	CheckVariables(function.name, function_location, diagnostics);
+	CheckVariables(function.return_type, function_location, diagnostics);
+	for (const auto& parameter : function.parameters) {
+		CheckVariables(parameter.first, function_location, diagnostics);
+		CheckVariables(parameter.second, function_location, diagnostics);
+	}
+	CheckTextVariables(function.body, function_location, diagnostics);
+	CheckIncludes(function.body, function_location, diagnostics);
+}
+
+void ConfigValidator::CheckMember(const CodeGenConfig::MemberConfig& member, const std::string& location,
+								  std::vector<ConfigDiagnostic>* diagnostics) const {
+	const std::string member_location = NamedLocation(location, "member", member.name);
+	if (member.name.empty()) {
+		AddError(member_location, "Member name cannot be empty", diagnostics);
+	}
+	if (member.type.empty()) {
+		AddError(member_location, "Member type cannot be empty", diagnostics);
+	}
+	CheckVariables(member.name, member_location, diagnostics);
+	CheckVariables(member.type, member_location, diagnostics);
+	CheckTextVariables(member.initializer, member_location, diagnostics);
+	CheckTextVariables(member.comment, member_location, diagnostics);
+}
+
+void ConfigValidator::CheckDuplicateOutputs(std::vector<ConfigDiagnostic>* diagnostics) const {
+	// 输出路径 -> 生成它的配置文件名
+	std::unordered_map<std::string, std::string> outputs;
+	outputs.reserve(config_.files.size() * 2);
+	auto add_output = [&](const std::string& path, const std::string& owner) {
+		auto result = outputs.emplace(path, owner);
+		if (!result.second) {
+			AddError(owner, "Output path " + path + " is also generated by " + result.first->second, diagnostics);
+		}
+	};
+	for (const auto& file_config : config_.files) {
+		if (file_config.filename.empty()) {
+			continue;
+		}
+		add_output(file_config.filename, file_config.filename);
+		if (file_config.type == "dual") {
+			add_output(SourceFilename(file_config), file_config.filename);
+		}
+	}
+
+	// 复制的文件按文件名放在输出目录下，覆盖生成的文件或其他复制的文件
+	for (const auto& file_config : config_.files) {
+		for (const auto& copy_file : file_config.copy_files) {
+			std::string destination = boost::filesystem::path(copy_file).filename().string();
+			auto result = outputs.emplace(destination, file_config.filename);
+			if (!result.second) {
+				AddDiagnostic(ConfigDiagnostic::Severity::WARNING, file_config.filename,
+							  "Copied file " + copy_file + " overwrites " + destination + " from " + result.first->second,
+							  diagnostics);
+			}
+		}
+	}
+}
+
+void ConfigValidator::CheckStreamedOutputs(const CodeGenConfig::FileConfig& file_config, ConfigOutputPaths* outputs,
+										   std::vector<ConfigDiagnostic>* diagnostics) const {
+	// 与CheckDuplicateOutputs的规则相同：生成的路径重复是错误，复制的文件覆盖其他输出是警告
+	if (!file_config.filename.empty()) {
+		std::vector<std::string> paths(1, file_config.filename);
+		if (file_config.type == "dual") {
+			paths.push_back(SourceFilename(file_config));
+		}
+		for (const auto& path : paths) {
+			auto copied = outputs->copied.find(path);
+			if (copied != outputs->copied.end()) {
+				AddDiagnostic(ConfigDiagnostic::Severity::WARNING, copied->second,
+							  "Copied file " + path + " is overwritten by " + file_config.filename, diagnostics);
+			}
+			auto result = outputs->generated.emplace(path, file_config.filename);
+			if (!result.second) {
+				AddError(file_config.filename, "Output path " + path + " is also generated by " + result.first->second,
+						 diagnostics);
+			}
+		}
+	}
+
+	for (const auto& copy_file : file_config.copy_files) {
+		std::string destination = boost::filesystem::path(copy_file).filename().string();
+		auto generated = outputs->generated.find(destination);
+		if (generated != outputs->generated.end()) {
+			AddDiagnostic(ConfigDiagnostic::Severity::WARNING, file_config.filename,
+						  "Copied file " + copy_file + " overwrites " + destination + " from " + generated->second,
+						  diagnostics);
+			continue;
+		}
+		auto result = outputs->copied.emplace(destination, file_config.filename);
+		if (!result.second) {
+			AddDiagnostic(ConfigDiagnostic::Severity::WARNING, file_config.filename,
+						  "Copied file " + copy_file + " overwrites " + destination + " from " + result.first->second,
+						  diagnostics);
+		}
+	}
+}
+
+void ConfigValidator::CheckVariables(const std::string& text, const std::string& location,
+									 std::vector<ConfigDiagnostic>* diagnostics) const {
+	CheckVariables(text, location, ConfigDiagnostic::Severity::ERROR, diagnostics);
+}
+
+void ConfigValidator::CheckTextVariables(const std::string& text, const std::string& location,
+										 std::vector<ConfigDiagnostic>* diagnostics) const {
+	CheckVariables(text, location, ConfigDiagnostic::Severity::WARNING, diagnostics);
+}
+
+void ConfigValidator::CheckVariables(const std::string& text, const std::string& location,
+									 ConfigDiagnostic::Severity severity,
+									 std::vector<ConfigDiagnostic>* diagnostics) const {
+	if (!variables_) {
+		return;
+	}
+	size_t pos = text.find("${");
+	if (pos == std::string::npos) {
+		return;
+	}
+
+	// 同一段文本中重复出现的变量只报告一次
+	std::set<std::string> reported;
+	while (pos != std::string::npos) {
+		size_t close = FindPlaceholderEnd(text, pos + 2);
+		if (close == std::string::npos) {
+			// 没有结束的"${"按字面量输出，与展开时一致
+			break;
+		}
+		std::string name = text.substr(pos + 2, close - pos - 2);
+		std::string resolved_name;
+		VariableResolver::ExpandText(name, *variables_, &resolved_name);
+		if (!variables_->Find(resolved_name) && reported.insert(name).second) {
+			AddDiagnostic(severity, location, "Undefined variable ${" + name + "}", diagnostics);
+		}
+		pos = text.find("${", close + 1);
+	}
+}
+
+void ConfigValidator::CheckIncludes(const std::string& text, const std::string& location,
+									std::vector<ConfigDiagnostic>* diagnostics) const {
+	static const char kKeyword[] = "@include(";
+	static const size_t kKeywordSize = sizeof(kKeyword) - 1;
+
+	size_t pos = 0;
+	while ((pos = text.find(kKeyword, pos)) != std::string::npos) {
+		size_t end = text.find(')', pos + kKeywordSize);
+		if (end == std::string::npos) {
+			break;
+		}
+		std::string reference = text.substr(pos + kKeywordSize, end - pos - kKeywordSize);
+		std::string reason;
+		if (!CheckReference(reference, &reason)) {
+			AddError(location, WithReason("Unresolved @include(" + reference + ")", reason), diagnostics);
+		}
+		pos = end + 1;
+	}
+}
+
+bool ConfigValidator::CheckReference(const std::string& reference, std::string* reason) const {
+	if (config_.code_templates.find(reference) != config_.code_templates.end()) {
+		return true;
+	}
+	if (!reference_checker_) {
+		return true;
+	}
+	return reference_checker_(reference, reason);
+}
+
+} // namespace code_generator
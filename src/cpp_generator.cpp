@@ -3,82 +3,291 @@
 
 namespace code_generator {
 
-std::string CppType::ToString() const {
-    std::string result;
-    if (is_const) {
-        result += "const ";
+AccessSpecifier ParseAccessSpecifier(const std::string& text, AccessSpecifier fallback) {
+    if (text == "public") {
+        return AccessSpecifier::PUBLIC;
     }
-    result += name;
-    if (is_pointer) {
-        result += "*";
+    if (text == "protected") {
+        return AccessSpecifier::PROTECTED;
     }
-    if (is_reference) {
-        result += "&";
+    if (text == "private") {
+        return AccessSpecifier::PRIVATE;
     }
-    return result;
+    return fallback;
 }
 
-std::string CppParameter::ToString() const {
-    std::string result = type.ToString() + " " + name;
-    if (!default_value.empty()) {
-        result += " = " + default_value;
+const char* AccessSpecifierName(AccessSpecifier access) {
+    switch (access) {
+    case AccessSpecifier::PUBLIC:
+        return "public";
+    case AccessSpecifier::PROTECTED:
+        return "protected";
+    case AccessSpecifier::PRIVATE:
+        return "private";
     }
-    return result;
+    return "";
 }
 
-std::string CppFunction::GetSignature() const {
-    std::string result;
-    
-    if (is_virtual) {
-        result += "virtual ";
+namespace {
+
+// 签名片段的输出目标：字符串或格式化器
+inline void AppendPiece(std::string* out, const char* text) {
+    out->append(text);
+}
+
+inline void AppendPiece(std::string* out, const std::string& text) {
+    out->append(text);
+}
+
+inline void AppendPiece(Formatter* out, const char* text) {
+    out->Print(text);
+}
+
+inline void AppendPiece(Formatter* out, const std::string& text) {
+    out->Print(text);
+}
+
+template<typename Sink>
+void AppendType(const CppType& type, Sink* sink) {
+    if (type.is_const) {
+        AppendPiece(sink, "const ");
     }
-    if (is_static) {
-        result += "static ";
+    AppendPiece(sink, type.name.str());
+    if (type.is_pointer) {
+        AppendPiece(sink, "*");
     }
-    
-    result += return_type + " " + name + "(";
-    
-    for (size_t i = 0; i < parameters.size(); ++i) {
+    if (type.is_reference) {
+        AppendPiece(sink, "&");
+    }
+}
+
+template<typename Sink>
+void AppendParameter(const CppParameter& param, Sink* sink, bool with_default) {
+    AppendType(param.type, sink);
+    AppendPiece(sink, " ");
+    AppendPiece(sink, param.name);
+    if (with_default && !param.default_value.empty()) {
+        AppendPiece(sink, " = ");
+        AppendPiece(sink, param.default_value);
+    }
+}
+
+template<typename Sink>
+void AppendParameterList(const CppFunction& func, Sink* sink, bool with_defaults) {
+    AppendPiece(sink, "(");
+    for (size_t i = 0; i < func.parameters.size(); ++i) {
         if (i > 0) {
-            result += ", ";
+            AppendPiece(sink, ", ");
         }
-        result += parameters[i].ToString();
+        AppendParameter(func.parameters[i], sink, with_defaults);
+    }
+    AppendPiece(sink, ")");
+}
+
+template<typename Sink>
+void AppendSignature(const CppFunction& func, Sink* sink) {
+    if (func.is_virtual) {
+        AppendPiece(sink, "virtual ");
+    }
+    if (func.is_static) {
+        AppendPiece(sink, "static ");
     }
     
-    result += ")";
+    AppendPiece(sink, func.return_type.str());
+    AppendPiece(sink, " ");
+    AppendPiece(sink, func.name);
+    AppendParameterList(func, sink, true);
     
-    if (is_const) {
-        result += " const";
+    if (func.is_const) {
+        AppendPiece(sink, " const");
     }
     
-    if (is_pure_virtual) {
-        result += " = 0";
+    if (func.is_pure_virtual) {
+        AppendPiece(sink, " = 0");
+    }
+}
+
+template<typename Sink>
+void AppendDefinitionSignature(const CppFunction& func, const std::string& class_name, Sink* sink) {
+    if (!func.return_type.empty()) {
+        AppendPiece(sink, func.return_type.str());
+        AppendPiece(sink, " ");
+    }
+    if (!class_name.empty()) {
+        AppendPiece(sink, class_name);
+        AppendPiece(sink, "::");
     }
+    AppendPiece(sink, func.name);
+    // 默认参数只能出现在声明中
+    AppendParameterList(func, sink, false);
     
+    if (func.is_const) {
+        AppendPiece(sink, " const");
+    }
+}
+
+template<typename Sink>
+void AppendMember(const CppMember& member, Sink* sink) {
+    AppendType(member.type, sink);
+    AppendPiece(sink, " ");
+    AppendPiece(sink, member.name);
+    if (!member.initializer.empty()) {
+        AppendPiece(sink, " = ");
+        AppendPiece(sink, member.initializer);
+    }
+    AppendPiece(sink, ";");
+}
+
+} // namespace
+
+std::string CppType::ToString() const {
+    std::string result;
+    AppendTo(&result);
+    return result;
+}
+
+void CppType::AppendTo(std::string* out) const {
+    AppendType(*this, out);
+}
+
+void CppType::AppendTo(Formatter& formatter) const {
+    AppendType(*this, &formatter);
+}
+
+std::string CppParameter::ToString() const {
+    std::string result;
+    AppendTo(&result);
+    return result;
+}
+
+void CppParameter::AppendTo(std::string* out) const {
+    AppendParameter(*this, out, true);
+}
+
+void CppParameter::AppendTo(Formatter& formatter) const {
+    AppendParameter(*this, &formatter, true);
+}
+
+#ifdef CODE_GENERATOR_HAS_PMR
+CppFunction::CppFunction(const ModelAllocator& alloc)
+    : parameters(alloc), body(alloc) {
+}
+#else
+CppFunction::CppFunction(const ModelAllocator& alloc) {
+}
+#endif
+
+// 赋值不传播分配器，因此先按目标分配器构造再赋值
+CppFunction::CppFunction(const CppFunction& other, const ModelAllocator& alloc)
+    : CppFunction(alloc) {
+    *this = other;
+}
+
+CppFunction::CppFunction(CppFunction&& other, const ModelAllocator& alloc)
+    : CppFunction(alloc) {
+    *this = std::move(other);
+}
+
+CppParameter& CppFunction::AddParameter(Symbol type_name, std::string param_name,
+                                        std::string default_value) {
+    parameters.emplace_back();
+    CppParameter& param = parameters.back();
+    param.type.name = type_name;
+    param.name = std::move(param_name);
+    param.default_value = std::move(default_value);
+    return param;
+}
+
+std::string CppFunction::GetSignature() const {
+    std::string result;
+    AppendTo(&result);
     return result;
 }
 
+std::string CppFunction::GetDefinitionSignature(const std::string& class_name) const {
+    std::string result;
+    AppendDefinitionTo(&result, class_name);
+    return result;
+}
+
+void CppFunction::AppendTo(std::string* out) const {
+    AppendSignature(*this, out);
+}
+
+void CppFunction::AppendTo(Formatter& formatter) const {
+    AppendSignature(*this, &formatter);
+}
+
+void CppFunction::AppendDefinitionTo(std::string* out, const std::string& class_name) const {
+    AppendDefinitionSignature(*this, class_name, out);
+}
+
+void CppFunction::AppendDefinitionTo(Formatter& formatter, const std::string& class_name) const {
+    AppendDefinitionSignature(*this, class_name, &formatter);
+}
+
 std::string CppMember::ToString() const {
-    std::string result = type.ToString() + " " + name;
-    if (!initializer.empty()) {
-        result += " = " + initializer;
-    }
-    return result + ";";
+    std::string result;
+    AppendTo(&result);
+    return result;
+}
+
+void CppMember::AppendTo(std::string* out) const {
+    AppendMember(*this, out);
+}
+
+void CppMember::AppendTo(Formatter& formatter) const {
+    AppendMember(*this, &formatter);
+}
+
+#ifdef CODE_GENERATOR_HAS_PMR
+CppClass::CppClass(const ModelAllocator& alloc)
+    : base_classes(alloc), members(alloc), functions(alloc), forward_declarations(alloc) {
+}
+#else
+CppClass::CppClass(const ModelAllocator& alloc) {
+}
+#endif
+
+CppClass::CppClass(const CppClass& other, const ModelAllocator& alloc)
+    : CppClass(alloc) {
+    *this = other;
+}
+
+CppClass::CppClass(CppClass&& other, const ModelAllocator& alloc)
+    : CppClass(alloc) {
+    *this = std::move(other);
 }
 
 void CppClass::AddFunction(const CppFunction& func) {
     functions.push_back(func);
 }
 
+void CppClass::AddFunction(CppFunction&& func) {
+    functions.push_back(std::move(func));
+}
+
 void CppClass::AddMember(const CppMember& member) {
     members.push_back(member);
 }
 
+void CppClass::AddMember(CppMember&& member) {
+    members.push_back(std::move(member));
+}
+
 CppGenerator::CppGenerator(code_generator::ZeroCopyOutputStreamPtr output, const CppGeneratorOptions& options)
     : formatter_(output, options.indent_style, options.use_braces),
       options_(options) {
 }
 
+CppGenerator::CppGenerator(ZeroCopyOutputStreamPtr header_output,
+                           ZeroCopyOutputStreamPtr source_output,
+                           const CppGeneratorOptions& options)
+    : formatter_(header_output, options.indent_style, options.use_braces),
+      source_formatter_(new Formatter(source_output, options.indent_style, options.use_braces)),
+      options_(options) {
+}
+
 void CppGenerator::BeginFile(const std::string& filename, const std::vector<std::string>& includes) {
     current_filename_ = filename;
 
@@ -97,6 +306,23 @@ void CppGenerator::BeginFile(const std::string& filename, const std::vector<std:
     formatter_.EndLine();
 }
 
+void CppGenerator::BeginDualFile(const std::string& header_filename, const std::string& source_filename,
+                                 const std::vector<std::string>& includes) {
+    BeginFile(header_filename, includes);
+    if (!source_formatter_) {
+        return;
+    }
+    
+    // 源文件先包含自己的头文件，再包含公共头文件
+    if (options_.generate_comments) {
+        WriteFileHeader(*source_formatter_, source_filename);
+    }
+    std::string header_name = header_filename.substr(header_filename.find_last_of('/') + 1);
+    source_formatter_->Include("\"" + header_name + "\"");
+    GenerateIncludes(*source_formatter_, includes);
+    source_formatter_->EndLine();
+}
+
 void CppGenerator::EndFile() {
     if (options_.use_include_guards && !options_.use_pragma_once) {
         GenerateIncludeGuards(false);
@@ -105,22 +331,74 @@ void CppGenerator::EndFile() {
 
 void CppGenerator::BeginNamespace(const std::string& name) {
     formatter_.Namespace(name);
+    if (source_formatter_) {
+        source_formatter_->Namespace(name);
+    }
 }
 
 void CppGenerator::EndNamespace() {
     formatter_.EndNamespace();
+    if (source_formatter_) {
+        source_formatter_->EndNamespace();
+    }
 }
 
 void CppGenerator::GenerateClass(const CppClass& cls) {
+    if (source_formatter_) {
+        GenerateClassDual(cls);
+        return;
+    }
     GenerateClassDeclaration(cls);
     formatter_.EndLine();
     GenerateClassImplementation(cls);
 }
 
+// 按访问权限分组的声明，只保存指向模型节点的指针
+struct CppGenerator::ClassLayout {
+    std::vector<const CppFunction*> functions[kAccessSpecifierCount];
+    std::vector<const CppMember*> members[kAccessSpecifierCount];
+    
+    void AddFunction(const CppFunction& func) {
+        functions[static_cast<int>(func.access_specifier)].push_back(&func);
+    }
+    void AddMember(const CppMember& member) {
+        members[static_cast<int>(member.access_specifier)].push_back(&member);
+    }
+};
+
 void CppGenerator::GenerateClassDeclaration(const CppClass& cls) {
+    ClassLayout layout;
+    for (const auto& func : cls.functions) {
+        layout.AddFunction(func);
+    }
+    for (const auto& member : cls.members) {
+        layout.AddMember(member);
+    }
+    
+    WriteClassDeclaration(cls, layout);
+}
+
+void CppGenerator::GenerateClassDual(const CppClass& cls) {
+    // 一次遍历：定义直接写入源文件，声明按访问权限暂存指针
+    ClassLayout layout;
+    for (const auto& func : cls.functions) {
+        layout.AddFunction(func);
+        if (!func.body.empty() && !func.is_pure_virtual) {
+            WriteFunctionImplementation(*source_formatter_, func, cls.name, true);
+            source_formatter_->EndLine();
+        }
+    }
+    for (const auto& member : cls.members) {
+        layout.AddMember(member);
+    }
+    
+    WriteClassDeclaration(cls, layout);
+}
+
+void CppGenerator::WriteClassDeclaration(const CppClass& cls, const ClassLayout& layout) {
     // 前向声明
     for (const auto& decl : cls.forward_declarations) {
-        formatter_.AddLine(decl);
+        formatter_.Print(decl.data(), decl.size()).EndLine();
     }
     if (!cls.forward_declarations.empty()) {
         formatter_.EndLine();
@@ -128,73 +406,42 @@ void CppGenerator::GenerateClassDeclaration(const CppClass& cls) {
     
     // 类定义
     std::string inheritance;
-    if (!cls.base_classes.empty()) {
-        inheritance = "public " + cls.base_classes[0];
-        for (size_t i = 1; i < cls.base_classes.size(); ++i) {
-            inheritance += ", public " + cls.base_classes[i];
-        }
+    for (size_t i = 0; i < cls.base_classes.size(); ++i) {
+        inheritance += i == 0 ? "public " : ", public ";
+        inheritance.append(cls.base_classes[i].data(), cls.base_classes[i].size());
     }
 
     // 使用手动作用域管理而不是 OpenBlock
     formatter_.Class(cls.name, inheritance);
 
-    // 成员变量和函数按访问权限分组
-    std::map<std::string, std::vector<CppMember> > members_by_access;
-    std::map<std::string, std::vector<CppFunction> > functions_by_access;
-
-    for (const auto& member : cls.members) {
-        members_by_access[member.access_specifier].push_back(member);
-    }
-
-    for (const auto& func : cls.functions) {
-        functions_by_access[func.access_specifier].push_back(func);
-    }
-
-    // 生成public部分
-    if (functions_by_access.count("public") || members_by_access.count("public")) {
-        formatter_.Public();
-
-        for (const auto& func : functions_by_access["public"]) {
-            GenerateFunctionDeclaration(func);
-        }
-
-        for (const auto& member : members_by_access["public"]) {
-            if (options_.generate_comments) {
-                GenerateMemberComment(member);
-            }
-            formatter_.AddLine(member.ToString());
+    // 依次生成public、protected、private部分
+    for (int access = 0; access < kAccessSpecifierCount; ++access) {
+        if (layout.functions[access].empty() && layout.members[access].empty()) {
+            continue;
         }
-    }
 
-    // 生成protected部分
-    if (functions_by_access.count("protected") || members_by_access.count("protected")) {
-        formatter_.Protected();
-
-        for (const auto& func : functions_by_access["protected"]) {
-            GenerateFunctionDeclaration(func);
+        switch (static_cast<AccessSpecifier>(access)) {
+        case AccessSpecifier::PUBLIC:
+            formatter_.Public();
+            break;
+        case AccessSpecifier::PROTECTED:
+            formatter_.Protected();
+            break;
+        case AccessSpecifier::PRIVATE:
+            formatter_.Private();
+            break;
         }
 
-        for (const auto& member : members_by_access["protected"]) {
-            if (options_.generate_comments) {
-                GenerateMemberComment(member);
-            }
-            formatter_.AddLine(member.ToString());
+        for (const CppFunction* func : layout.functions[access]) {
+            GenerateFunctionDeclaration(*func);
         }
-    }
-
-    // 生成private部分
-    if (functions_by_access.count("private") || members_by_access.count("private")) {
-        formatter_.Private();
 
-        for (const auto& func : functions_by_access["private"]) {
-            GenerateFunctionDeclaration(func);
-        }
-
-        for (const auto& member : members_by_access["private"]) {
+        for (const CppMember* member : layout.members[access]) {
             if (options_.generate_comments) {
-                GenerateMemberComment(member);
+                GenerateMemberComment(*member);
             }
-            formatter_.AddLine(member.ToString());
+            member->AppendTo(formatter_);
+            formatter_.EndLine();
         }
     }
 
@@ -213,6 +460,11 @@ void CppGenerator::GenerateClassImplementation(const CppClass& cls, const std::s
 void CppGenerator::GenerateFunction(const CppFunction& func, bool in_class) {
     if (in_class) {
         GenerateFunctionDeclaration(func);
+    } else if (source_formatter_) {
+        // 双输出模式：头文件声明，源文件实现
+        GenerateFunctionDeclaration(func);
+        WriteFunctionImplementation(*source_formatter_, func, "", true);
+        source_formatter_->EndLine();
     } else {
         GenerateFunctionImplementation(func);
     }
@@ -222,42 +474,43 @@ void CppGenerator::GenerateFunctionDeclaration(const CppFunction& func) {
     if (options_.generate_comments) {
         GenerateFunctionComment(func);
     }
-    formatter_.AddLine(func.GetSignature() + ";");
+    func.AppendTo(formatter_);
+    formatter_.Print(";").EndLine();
 }
 
 void CppGenerator::GenerateFunctionImplementation(const CppFunction& func, const std::string& class_name) {
-    std::string signature = func.GetSignature();
-    if (!class_name.empty()) {
-        // 插入类名作用域
-        size_t pos = signature.find(func.name);
-        if (pos != std::string::npos) {
-            signature.insert(pos, class_name + "::");
-        }
+    WriteFunctionImplementation(formatter_, func, class_name, false);
+}
+
+void CppGenerator::WriteFunctionImplementation(Formatter& formatter, const CppFunction& func,
+                                               const std::string& class_name, bool has_declaration) {
+    // 已有声明的定义（类成员或双输出模式）不能带virtual/static和默认参数
+    if (has_declaration || !class_name.empty()) {
+        func.AppendDefinitionTo(formatter, class_name);
+    } else {
+        func.AppendTo(formatter);
     }
     
     // 使用手动作用域管理
-    formatter_.AddLine(signature);
-    formatter_.OpenBlockInternal();
+    formatter.EndLine();
+    formatter.OpenBlockInternal();
 
     if (!func.body.empty()) {
-        std::vector<std::string> lines;
+        // 逐行直接写出，不拆分成临时字符串
+        const ModelString& body = func.body;
         size_t start = 0;
-        size_t end = func.body.find('\n');
-        
-        while (end != std::string::npos) {
-            lines.push_back(func.body.substr(start, end - start));
+        while (start < body.length()) {
+            size_t end = body.find('\n', start);
+            if (end == ModelString::npos) {
+                end = body.length();
+            }
+            formatter.Print(body.data() + start, end - start).EndLine();
             start = end + 1;
-            end = func.body.find('\n', start);
         }
-        if (start < func.body.length()) {
-            lines.push_back(func.body.substr(start));
-        }
-        
-        formatter_.Print(lines);
     } else {
-        formatter_.AddComment("TODO: Implement function body");
+        formatter.AddComment("TODO: Implement function body");
     }
-    formatter_.CloseBlock();
+    formatter.CloseBlock();
 }
 
 void CppGenerator::GenerateEnum(const std::string& name, const std::vector<std::string>& values, const std::string& type) {
@@ -285,34 +538,53 @@ void CppGenerator::GenerateEnum(const std::string& name, const std::vector<std::
     formatter_.Enum(name, values);
 }
 
+// 访问器名由成员名派生，只在这里用一次，直接写出而不经过CppFunction，避免驻留到符号表
 void CppGenerator::GenerateGetter(const CppMember& member) {
-    CppFunction getter;
-    getter.return_type = "const " + member.type.ToString() + "&";
-    getter.name = "Get" + member.name;
-    getter.is_const = true;
-    getter.body = "return " + member.name + ";";
-    
-    GenerateFunction(getter, true);
+    const std::string& name = member.name;
+    if (options_.generate_comments) {
+        formatter_.AddComment("Get" + name + " - ");
+    }
+    formatter_.Print("const ");
+    member.type.AppendTo(formatter_);
+    formatter_.Print("& Get").Print(name).Print("() const;").EndLine();
 }
 
 void CppGenerator::GenerateSetter(const CppMember& member) {
-    CppFunction setter;
-    setter.return_type = "void";
-    setter.name = "Set" + member.name;
-    setter.parameters.push_back({member.type, "value", ""});
-    setter.body = member.name + " = value;";
+    const std::string& name = member.name;
+    if (options_.generate_comments) {
+        formatter_.AddComment("Set" + name + " - Parameters: value");
+    }
+    formatter_.Print("void Set").Print(name).Print("(");
+    member.type.AppendTo(formatter_);
+    formatter_.Print(" value);").EndLine();
+}
+
+void CppGenerator::GenerateGlobal(const CppMember& global) {
+    if (!source_formatter_) {
+        global.AppendTo(formatter_);
+        formatter_.EndLine();
+        return;
+    }
     
-    GenerateFunction(setter, true);
+    formatter_.Print("extern ");
+    global.type.AppendTo(formatter_);
+    formatter_.Print(" ").Print(global.name).Print(";").EndLine();
+    global.AppendTo(*source_formatter_);
+    source_formatter_->EndLine();
 }
 
 void CppGenerator::GenerateFileHeader(const std::string& filename) {
+    WriteFileHeader(formatter_, filename);
+}
+
+void CppGenerator::WriteFileHeader(Formatter& formatter, const std::string& filename) {
     if (!options_.file_header_comment.empty()) {
-        formatter_.AddComment(options_.file_header_comment);
+        formatter.AddComment(options_.file_header_comment);
     } else {
-        formatter_.AddComment("Generated by CppGenerator");
-        formatter_.AddComment("File: " + filename);
+        formatter.AddComment("Generated by CppGenerator");
+        formatter.AddComment("File: " + filename);
     }
-    formatter_.EndLine();
+    formatter.EndLine();
 }
 
 void CppGenerator::GenerateFunctionComment(const CppFunction& func) {
@@ -343,11 +615,15 @@ void CppGenerator::GenerateIncludeGuards(bool begin) {
 }
 
 void CppGenerator::GenerateIncludes(const std::vector<std::string>& includes) {
+    GenerateIncludes(formatter_, includes);
+}
+
+void CppGenerator::GenerateIncludes(Formatter& formatter, const std::vector<std::string>& includes) {
     for (const auto& include : includes) {
         if (include.find('<') != std::string::npos || include.find('>') != std::string::npos) {
-            formatter_.Include(include);
+            formatter.Include(include);
         } else {
-            formatter_.Include("\"" + include + "\"");
+            formatter.Include("\"" + include + "\"");
         }
     }
 }
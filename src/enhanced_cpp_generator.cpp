@@ -1,59 +1,115 @@
 // enhanced_cpp_generator.cpp
 #include "code_generator/enhanced_cpp_generator.h"
 #include "code_generator/stream_adapters.h"
+#include "code_generator/build_manifest.h"
+#include "code_generator/file_streams.h"
+#include <stdexcept>
 #include <fstream>
+#include <iostream>
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <boost/filesystem.hpp>
 
 namespace code_generator{
 
 EnhancedCppGenerator::EnhancedCppGenerator(const std::string& output_dir)
-    : output_dir_(output_dir) {
+    : output_dir_(output_dir), use_model_arena_(false), incremental_(false),
+      write_if_changed_(false), streaming_(false), library_cache_(std::make_shared<CodeLibraryCache>()),
+      error_stream_(&std::cerr),
+      include_expander_(new IncludeExpander([this](const std::string& reference) {
+          return ResolveCodeReferenceText(reference);
+      })) {
     // 创建输出目录
     EnsureDirectory(output_dir_);
 }
 
 bool EnhancedCppGenerator::GenerateFromConfig(const code_generator::CodeGenConfig::ProjectConfig& config) {
+    // 先完整校验一遍，所有问题一次报告，有错误时不写任何文件
+    std::vector<ConfigDiagnostic> diagnostics;
+    bool valid = ValidateConfig(config, &diagnostics);
+    ConfigValidator::PrintReport(diagnostics, *error_stream_);
+    if (!valid) {
+        return false;
+    }
+    
     // 设置输出目录
     if (!config.output_dir.empty()) {
         output_dir_ = config.output_dir;
         EnsureDirectory(output_dir_);
     }
     
-    // 生成所有文件
-    for (const auto& file_config : config.files) {
-        if (!GenerateFile(file_config)) {
-            return false;
+    // 配置可能已更换，之前展开的@include结果不再可靠
+    include_expander_->ClearCache();
+    
+    // 增量模式：读取上次的指纹清单，输入未变化的文件直接跳过
+    BuildManifest manifest;
+    std::string manifest_path = output_dir_ + "/" + BuildManifest::kFileName;
+    if (incremental_) {
+        manifest.Load(manifest_path);
+    }
+    
+    // 各文件相互独立，有线程池时并行生成；错误信息按文件顺序输出
+    const size_t file_count = config.files.size();
+    std::vector<std::string> errors(file_count);
+    std::vector<std::string> fingerprints(file_count);
+    std::vector<char> succeeded(file_count, 0);
+    auto generate_file = [&](size_t i) {
+        succeeded[i] = GenerateFileIncremental(config, config.files[i], manifest, &fingerprints[i], &errors[i]) ? 1 : 0;
+    };
+    
+    // 输出路径有重复时，写入先后会影响结果，退回串行执行
+    bool parallel = thread_pool_ && file_count > 1 && !HasConflictingOutputs(config.files);
+    if (parallel) {
+        thread_pool_->ParallelFor(file_count, generate_file);
+    } else {
+        for (size_t i = 0; i < file_count; ++i) {
+            generate_file(i);
+            if (!succeeded[i]) {
+                break;
+            }
         }
     }
     
-    // 处理文件复制
-    for (const auto& file_config : config.files) {
-        for (const auto& copy_file : file_config.copy_files) {
-            std::string source = copy_file;
-            //std::string destination = output_dir_ + "/" + std::filesystem::path(copy_file).filename().string();
-            std::string destination = output_dir_ + "/" + boost::filesystem::path(copy_file).filename().string();
-            
-            if (!CopyFile(source, destination)) {
-                // 如果直接复制失败，尝试解析为代码库引用
-                std::string resolved_code = ResolveCodeReference(copy_file);
-                if (!resolved_code.empty()) {
-                    std::ofstream out_file(destination);
-                    if (out_file) {
-                        out_file << resolved_code;
-                    }
-                }
+    bool all_succeeded = true;
+    for (size_t i = 0; i < file_count; ++i) {
+        if (!succeeded[i]) {
+            if (!errors[i].empty()) {
+                *error_stream_ << errors[i] << std::endl;
+            }
+            all_succeeded = false;
+            // 串行模式下后续文件没有生成
+            if (!parallel) {
+                break;
             }
         }
-        
-        // 处理代码片段插入
-        for (const auto& snippet_ref : file_config.insert_snippets) {
-            std::string file_path = output_dir_ + "/" + file_config.filename;
-            std::string snippet = ResolveCodeReference(snippet_ref);
-            if (!snippet.empty()) {
-                InsertSnippet(file_path, snippet);
+    }
+    
+    if (incremental_) {
+        // 只记录成功生成的文件，失败或未执行的文件下次重新生成
+        BuildManifest updated;
+        for (size_t i = 0; i < file_count; ++i) {
+            if (succeeded[i]) {
+                updated.Set(config.files[i].filename, fingerprints[i]);
             }
         }
+        if (!updated.Save(manifest_path)) {
+            *error_stream_ << "write manifest Error file:" << manifest_path << std::endl;
+        }
+    }
+    
+    if (!all_succeeded) {
+        return false;
+    }
+    
+    // 处理文件复制（代码片段已在生成时写入）
+    if (parallel) {
+        thread_pool_->ParallelFor(file_count, [&](size_t i) { ProcessCopyFiles(config.files[i]); });
+    } else {
+        for (const auto& file_config : config.files) {
+            ProcessCopyFiles(file_config);
+        }
     }
 
     // 生成cmake
@@ -67,29 +123,415 @@ bool EnhancedCppGenerator::GenerateFromConfigFile(const std::string& config_file
     if (!config_parser_) {
         config_parser_ = std::make_shared<code_generator::ConfigParser>();
     }
+    if (!config_cache_dir_.empty()) {
+        config_parser_->SetCacheDirectory(config_cache_dir_);
+    }
     
+    if (streaming_) {
+        // 流式加载无法做整体校验，引用和重复的输出路径在每个文件到达时检查
+        config_parser_->SetStreamReferenceChecker([this](const std::string& reference, std::string* reason) {
+            return CheckCodeReference(reference, reason);
+        });
+        return GenerateFromConfigStream(config_file);
+    }
+    
+    // GenerateFromConfig会完整校验，加载时不再重复检查
+    config_parser_->SetValidateOnLoad(false);
     if (!config_parser_->LoadFromFile(config_file)) {
-        std::cerr << "load from file: "  << config_file << ". Error:" << config_parser_->GetError() << std::endl;
+        *error_stream_ << "load from file: "  << config_file << ". Error:" << config_parser_->GetError() << std::endl;
         return false;
     }
     
     return GenerateFromConfig(config_parser_->GetProjectConfig());
 }
 
-bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::FileConfig& file_config) {
-    std::string file_path = output_dir_ + "/" + file_config.filename;
+bool EnhancedCppGenerator::ValidateConfig(const code_generator::CodeGenConfig::ProjectConfig& config,
+                                          std::vector<ConfigDiagnostic>* diagnostics) {
+    ConfigValidator validator(config);
+    // 变量表只对应解析器自己的配置
+    if (config_parser_ && &config_parser_->GetProjectConfig() == &config) {
+        validator.SetVariables(&config_parser_->GetVariableTable());
+    }
+    validator.SetReferenceChecker([this](const std::string& reference, std::string* reason) {
+        return CheckCodeReference(reference, reason);
+    });
+    validator.SetThreadPool(thread_pool_);
+    return validator.Validate(diagnostics);
+}
+
+bool EnhancedCppGenerator::ValidateConfigFile(const std::string& config_file) {
+    if (!config_parser_) {
+        config_parser_ = std::make_shared<code_generator::ConfigParser>();
+    }
+    // 校验失败的配置也要加载完，才能报告全部问题
+    config_parser_->SetValidateOnLoad(false);
+    if (!config_parser_->LoadFromFile(config_file)) {
+        *error_stream_ << "load from file: "  << config_file << ". Error:" << config_parser_->GetError() << std::endl;
+        return false;
+    }
+    
+    std::vector<ConfigDiagnostic> diagnostics;
+    bool valid = ValidateConfig(config_parser_->GetProjectConfig(), &diagnostics);
+    ConfigValidator::PrintReport(diagnostics, *error_stream_);
+    return valid;
+}
+
+struct EnhancedCppGenerator::StreamBatch {
+    StreamBatch() : claimed(false), done(false) {}
+    
+    std::vector<code_generator::CodeGenConfig::FileConfig> files;
+    std::vector<std::string> errors;
+    std::vector<std::string> fingerprints;
+    std::vector<char> succeeded;
+    std::atomic<bool> claimed;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done;
+};
+
+bool EnhancedCppGenerator::GenerateFromConfigStream(const std::string& config_file) {
+    BuildManifest manifest;
+    BuildManifest updated;
+    std::string manifest_path;
+    bool all_succeeded = true;
+    bool generation_stopped = false;
+    std::shared_ptr<StreamBatch> running;
+    std::shared_ptr<StreamBatch> filling = std::make_shared<StreamBatch>();
+    const code_generator::CodeGenConfig::ProjectConfig& config = config_parser_->GetProjectConfig();
+    
+    // 等待上一批完成，按文件顺序输出错误并记录指纹
+    auto finish_running = [&]() {
+        if (!running) {
+            return;
+        }
+        WaitStreamBatch(running.get(), config, manifest);
+        for (size_t i = 0; i < running->files.size(); ++i) {
+            if (running->succeeded[i]) {
+                updated.Set(running->files[i].filename, running->fingerprints[i]);
+            } else {
+                if (!running->errors[i].empty()) {
+                    *error_stream_ << running->errors[i] << std::endl;
+                }
+                all_succeeded = false;
+            }
+        }
+        running.reset();
+    };
+    
+    // 上一批完成后再提交下一批，解析线程继续解析后续文件，内存中最多两批
+    auto dispatch_filling = [&]() {
+        finish_running();
+        running = filling;
+        filling = std::make_shared<StreamBatch>();
+        std::shared_ptr<StreamBatch> batch = running;
+        thread_pool_->Submit([this, batch, &config, &manifest]() {
+            RunStreamBatch(batch.get(), config, manifest);
+        });
+    };
+    
+    auto on_project = [&](const code_generator::CodeGenConfig::ProjectConfig& project_config) {
+        if (!project_config.output_dir.empty()) {
+            output_dir_ = project_config.output_dir;
+            EnsureDirectory(output_dir_);
+        }
+        include_expander_->ClearCache();
+        manifest_path = output_dir_ + "/" + BuildManifest::kFileName;
+        if (incremental_) {
+            manifest.Load(manifest_path);
+        }
+        return true;
+    };
+    
+    auto on_file = [&](code_generator::CodeGenConfig::FileConfig&& file_config) {
+        if (!thread_pool_) {
+            // 串行模式与GenerateFromConfig一致：第一个失败的文件之后不再继续
+            std::string fingerprint;
+            std::string error;
+            if (!GenerateFileIncremental(config, file_config, manifest, &fingerprint, &error)) {
+                if (!error.empty()) {
+                    *error_stream_ << error << std::endl;
+                }
+                all_succeeded = false;
+                generation_stopped = true;
+                return false;
+            }
+            updated.Set(file_config.filename, fingerprint);
+            ProcessCopyFiles(file_config);
+            return true;
+        }
+        
+        filling->files.push_back(std::move(file_config));
+        if (filling->files.size() >= kStreamBatchFiles) {
+            dispatch_filling();
+        }
+        return true;
+    };
+    
+    bool loaded = config_parser_->LoadStreaming(config_file, on_project, on_file);
+    if (loaded && !filling->files.empty()) {
+        dispatch_filling();
+    }
+    // 已提交的任务引用了本函数的局部变量，返回前必须完成
+    finish_running();
+    
+    if (!loaded && !generation_stopped) {
+        *error_stream_ << "load from file: "  << config_file << ". Error:" << config_parser_->GetError() << std::endl;
+    }
+    
+    if (incremental_ && !manifest_path.empty()) {
+        if (!updated.Save(manifest_path)) {
+            *error_stream_ << "write manifest Error file:" << manifest_path << std::endl;
+        }
+    }
+    
+    return loaded && all_succeeded;
+}
+
+void EnhancedCppGenerator::RunStreamBatch(StreamBatch* batch, const code_generator::CodeGenConfig::ProjectConfig& config,
+                                          const BuildManifest& manifest) {
+    if (batch->claimed.exchange(true)) {
+        return;
+    }
     
-    // 创建文件输出流
-    std::ofstream file_stream(file_path);
-    if (!file_stream) {
-        std::cerr << "create Error file:" << file_path << std::endl;
+    const size_t file_count = batch->files.size();
+    batch->errors.resize(file_count);
+    batch->fingerprints.resize(file_count);
+    batch->succeeded.assign(file_count, 0);
+    auto generate_file = [&](size_t i) {
+        try {
+            if (GenerateFileIncremental(config, batch->files[i], manifest, &batch->fingerprints[i], &batch->errors[i])) {
+                // 流式模式下没有完整的文件列表，复制文件随各自的文件完成
+                ProcessCopyFiles(batch->files[i]);
+                batch->succeeded[i] = 1;
+            }
+        } catch (const std::exception& e) {
+            batch->errors[i] = "Error generating file " + batch->files[i].filename + ": " + e.what();
+        }
+    };
+    
+    if (file_count > 1 && !HasConflictingOutputs(batch->files)) {
+        thread_pool_->ParallelFor(file_count, generate_file);
+    } else {
+        for (size_t i = 0; i < file_count; ++i) {
+            generate_file(i);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    batch->done = true;
+    batch->done_cv.notify_all();
+}
+
+void EnhancedCppGenerator::WaitStreamBatch(StreamBatch* batch, const code_generator::CodeGenConfig::ProjectConfig& config,
+                                           const BuildManifest& manifest) {
+    // 线程池可能与其他项目共享且全部忙碌，尚未开始的批次由当前线程执行，避免互相等待
+    RunStreamBatch(batch, config, manifest);
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done_cv.wait(lock, [batch] { return batch->done; });
+}
+
+bool EnhancedCppGenerator::GenerateFileIncremental(const code_generator::CodeGenConfig::ProjectConfig& config,
+                                                   const code_generator::CodeGenConfig::FileConfig& file_config,
+                                                   const BuildManifest& manifest, std::string* fingerprint,
+                                                   std::string* error) {
+    if (incremental_) {
+        // 在模型转换和渲染之前比较指纹
+        *fingerprint = ComputeFingerprint(config, file_config);
+        if (manifest.Get(file_config.filename) == *fingerprint && OutputsExist(file_config)) {
+            return true;
+        }
+    }
+    return GenerateFile(file_config, error);
+}
+
+void EnhancedCppGenerator::ProcessCopyFiles(const code_generator::CodeGenConfig::FileConfig& file_config) {
+    for (const auto& copy_file : file_config.copy_files) {
+        std::string source = copy_file;
+        //std::string destination = output_dir_ + "/" + std::filesystem::path(copy_file).filename().string();
+        std::string destination = output_dir_ + "/" + boost::filesystem::path(copy_file).filename().string();
+        
+        if (!CopyFile(source, destination)) {
+            // 如果直接复制失败，尝试解析为代码库引用
+            IncludeExpander::Resolved resolved = ResolveCodeReferenceText(copy_file);
+            if (!resolved.text.empty()) {
+                std::ofstream out_file(destination, std::ios::out | std::ios::binary);
+                if (out_file) {
+                    out_file.write(resolved.text.data(), static_cast<std::streamsize>(resolved.text.size()));
+                }
+            }
+        }
+    }
+}
+
+void EnhancedCppGenerator::WriteSnippets(const code_generator::CodeGenConfig::FileConfig& file_config,
+                                         const std::string& anchor, CppGenerator& generator) {
+    for (const auto& snippet_config : file_config.insert_snippets) {
+        if (snippet_config.anchor != anchor) {
+            continue;
+        }
+        
+        // 代码库中的片段直接从内存映射写入输出
+        IncludeExpander::Resolved snippet = ResolveCodeReferenceText(snippet_config.reference);
+        if (snippet.text.empty()) {
+            continue;
+        }
+        
+        // 单输出模式下GetSourceFormatter返回的也是头文件格式化器
+        Formatter& formatter = snippet_config.target == "source" ? generator.GetSourceFormatter()
+                                                                 : generator.GetFormatter();
+        formatter.Raw("\n// Inserted snippet\n");
+        formatter.Raw(snippet.text.data(), snippet.text.size());
+        formatter.Raw("\n// End of inserted snippet\n");
+    }
+}
+
+bool EnhancedCppGenerator::HasConflictingOutputs(const std::vector<code_generator::CodeGenConfig::FileConfig>& files) const {
+    std::unordered_set<std::string> paths;
+    for (const auto& file_config : files) {
+        if (!paths.insert(file_config.filename).second) {
+            return true;
+        }
+        if (file_config.type == "dual" && !paths.insert(GetSourceFilename(file_config)).second) {
+            return true;
+        }
+    }
+    for (const auto& file_config : files) {
+        for (const auto& copy_file : file_config.copy_files) {
+            if (!paths.insert(boost::filesystem::path(copy_file).filename().string()).second) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string EnhancedCppGenerator::ComputeFingerprint(const code_generator::CodeGenConfig::ProjectConfig& config,
+                                                     const code_generator::CodeGenConfig::FileConfig& file_config) {
+    Fingerprint fingerprint;
+    fingerprint.Update(BuildManifest::kGeneratorVersion);
+    
+    std::string file_json = json::serialize(file_config.ToJson());
+    fingerprint.Update(file_json);
+    for (const auto& include : config.common_includes) {
+        fingerprint.Update(include);
+    }
+    
+    // 文件用到的模板、@include引用和代码片段按完整展开后的内容计入指纹：
+    // 被引用内容中嵌套的@include及其中的${VAR}同样影响输出
+    std::vector<std::string> references;
+    for (const auto& class_config : file_config.classes) {
+        references.insert(references.end(), class_config.templates.begin(), class_config.templates.end());
+    }
+    for (const auto& snippet_config : file_config.insert_snippets) {
+        references.push_back(snippet_config.reference);
+    }
+    size_t pos = 0;
+    while ((pos = file_json.find("@include(", pos)) != std::string::npos) {
+        size_t end_pos = file_json.find(")", pos);
+        if (end_pos == std::string::npos) break;
+        references.push_back(file_json.substr(pos + 9, end_pos - pos - 9));
+        pos = end_pos;
+    }
+    
+    std::string used_text = file_json;
+    for (const auto& reference : references) {
+        std::string expanded;
+        std::string error;
+        if (!include_expander_->ExpandReference(reference, &expanded, &error)) {
+            // 循环引用等错误在生成时报告，这里计入错误信息，修复后指纹随之变化
+            expanded = ResolveCodeReference(reference);
+            expanded += error;
+        }
+        fingerprint.Update(reference).Update(expanded);
+        used_text += expanded;
+    }
+    if (config.code_templates.count("function_comment")) {
+        fingerprint.Update(config.code_templates.at("function_comment"));
+    }
+    
+    // 只计入实际引用到的变量；TIMESTAMP每次运行都不同，不参与比较
+    // 扫描一遍占位符再按名称查找，按名称排序后计入，与变量在配置中的顺序无关
+    StringMap builtins;
+    builtins["PROJECT_NAME"] = config.name;
+    builtins["PROJECT_VERSION"] = config.version;
+    builtins["OUTPUT_DIR"] = config.output_dir;
+    std::map<boost::string_view, const std::string*> used_variables;
+    for (size_t begin = used_text.find("${"); begin != std::string::npos; begin = used_text.find("${", begin + 2)) {
+        size_t end = used_text.find('}', begin + 2);
+        if (end == std::string::npos) {
+            break;
+        }
+        boost::string_view name(used_text.data() + begin + 2, end - begin - 2);
+        if (name == "TIMESTAMP" || used_variables.count(name)) {
+            continue;
+        }
+        auto builtin = builtins.find(name);
+        auto variable = config.variables.find(name);
+        if (builtin != builtins.end()) {
+            used_variables[name] = &builtin->second;
+        } else if (variable != config.variables.end()) {
+            used_variables[name] = &variable->second;
+        }
+    }
+    for (const auto& iter : used_variables) {
+        fingerprint.Update(iter.first.data(), iter.first.size()).Update(*iter.second);
+    }
+    
+    return fingerprint.ToHex();
+}
+
+bool EnhancedCppGenerator::OutputsExist(const code_generator::CodeGenConfig::FileConfig& file_config) const {
+    if (!boost::filesystem::exists(output_dir_ + "/" + file_config.filename)) {
+        return false;
+    }
+    if (file_config.type == "dual" && !boost::filesystem::exists(output_dir_ + "/" + GetSourceFilename(file_config))) {
         return false;
     }
+    return true;
+}
+
+void EnhancedCppGenerator::SetJobs(size_t jobs) {
+    size_t workers = ThreadPool::WorkersForJobs(jobs);
+    if (workers > 0) {
+        thread_pool_ = std::make_shared<ThreadPool>(workers);
+    } else {
+        thread_pool_.reset();
+    }
+}
+
+bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::FileConfig& file_config) {
+    std::string error;
+    if (!GenerateFile(file_config, &error)) {
+        if (!error.empty()) {
+            *error_stream_ << error << std::endl;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error) {
+    // 模型转换中的配置错误（如@include循环引用）以异常形式抛出
+    try {
+        if (file_config.type == "dual") {
+            return GenerateDualFile(file_config, error);
+        }
+        return GenerateSingleFile(file_config, error);
+    } catch (const std::exception& e) {
+        *error = "generate Error file:" + file_config.filename + ": " + e.what();
+        return false;
+    }
+}
+
+bool EnhancedCppGenerator::GenerateSingleFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error) {
+    std::string file_path = output_dir_ + "/" + file_config.filename;
     
-    // 创建字符串输出流
-    //std::stringstream buffer;
+    // 默认直接流式写入文件；仅写入变化模式需要完整内容，先渲染到内存
     std::string buffer;
-    code_generator::ZeroCopyOutputStreamPtr string_output(new code_generator::StringOutputStream(&buffer));
+    code_generator::ZeroCopyOutputStreamPtr output = OpenOutput(file_path, &buffer, error);
+    if (!output) {
+        return false;
+    }
     
     // 创建格式化器
     CppGeneratorOptions options;
@@ -97,18 +539,17 @@ bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::Fil
     options.use_pragma_once = true;
     options.generate_comments = true;
     
-    CppGenerator generator(string_output, options);
+    CppGenerator generator(output, options);
     
-    // 开始文件
-    std::vector<std::string> includes = file_config.includes;
+    // 本文件的代码模型内存池
+    std::unique_ptr<CppModelArena> arena(use_model_arena_ ? new CppModelArena() : nullptr);
+    ModelAllocator alloc = arena ? arena->GetAllocator() : ModelAllocator();
     
-    // 添加公共包含
-    if (config_parser_) {
-        const auto& project_config = config_parser_->GetProjectConfig();
-        includes.insert(includes.end(), project_config.common_includes.begin(), project_config.common_includes.end());
-    }
+    // 开始文件
+    std::vector<std::string> includes = CollectIncludes(file_config);
     
     generator.BeginFile(file_config.filename, includes);
+    WriteSnippets(file_config, "after_includes", generator);
     
     // 处理命名空间
     std::vector<std::string> current_namespaces;
@@ -116,10 +557,11 @@ bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::Fil
         generator.BeginNamespace(ns);
         current_namespaces.push_back(ns);
     }
+    WriteSnippets(file_config, "namespace_begin", generator);
     
     // 生成全局函数
     for (const auto& func_config : file_config.functions) {
-        if (!GenerateFunction(func_config, generator.GetFormatter(), false)) {
+        if (!GenerateFunction(func_config, generator, false, alloc)) {
             return false;
         }
     }
@@ -133,108 +575,166 @@ bool EnhancedCppGenerator::GenerateFile(const code_generator::CodeGenConfig::Fil
     
     // 生成类
     for (const auto& class_config : file_config.classes) {
-        if (!GenerateClass(class_config, generator.GetFormatter())) {
+        if (!GenerateClass(class_config, generator, alloc)) {
             return false;
         }
     }
     
     // 结束命名空间
+    WriteSnippets(file_config, "namespace_end", generator);
     for (size_t i = 0; i < current_namespaces.size(); ++i) {
         generator.EndNamespace();
     }
     
     // 结束文件
     generator.EndFile();
+    WriteSnippets(file_config, "end_of_file", generator);
     
-    // 写入文件
-    //file_stream << buffer.str();
-    file_stream << buffer;
-    file_stream.close();
-    
-    return true;
+    return CloseOutput(output, file_path, buffer, error);
 }
 
-bool EnhancedCppGenerator::GenerateClass(const code_generator::CodeGenConfig::ClassConfig& class_config, code_generator::Formatter& formatter) {
-    CppClass cpp_class = ConvertToCppClass(class_config);
-    
-    // 使用CppGenerator生成类声明
-    //std::stringstream buffer;
-    std::string buffer;
-    code_generator::ZeroCopyOutputStreamPtr string_output(new code_generator::StringOutputStream(&buffer));
-    
-    CppGeneratorOptions options;
-    options.indent_style = code_generator::Formatter::IndentStyle::SPACES_2;
-    CppGenerator generator(string_output, options);
+std::string EnhancedCppGenerator::GetSourceFilename(const code_generator::CodeGenConfig::FileConfig& file_config) const {
+    return ConfigValidator::SourceFilename(file_config);
+}
+
+bool EnhancedCppGenerator::GenerateDualFile(const code_generator::CodeGenConfig::FileConfig& file_config, std::string* error) {
+    std::string source_filename = GetSourceFilename(file_config);
     
-    generator.GenerateClassDeclaration(cpp_class);
+    std::string header_path = output_dir_ + "/" + file_config.filename;
+    std::string source_path = output_dir_ + "/" + source_filename;
     
-    // 将生成的代码写入主格式化器
-    //std::string class_code = buffer.str();
-    std::string class_code = buffer;
-    std::vector<std::string> lines;
+    std::string header_buffer;
+    std::string source_buffer;
+    code_generator::ZeroCopyOutputStreamPtr header_output = OpenOutput(header_path, &header_buffer, error);
+    if (!header_output) {
+        return false;
+    }
+    code_generator::ZeroCopyOutputStreamPtr source_output = OpenOutput(source_path, &source_buffer, error);
+    if (!source_output) {
+        return false;
+    }
+    {
+        CppGeneratorOptions options;
+        options.indent_style = code_generator::Formatter::IndentStyle::SPACES_2;
+        options.use_pragma_once = true;
+        options.generate_comments = true;
+        
+        std::unique_ptr<CppModelArena> arena(use_model_arena_ ? new CppModelArena() : nullptr);
+        ModelAllocator alloc = arena ? arena->GetAllocator() : ModelAllocator();
+        
+        // 一次遍历配置，同时写出头文件和源文件
+        CppGenerator generator(header_output, source_output, options);
+        generator.BeginDualFile(file_config.filename, source_filename, CollectIncludes(file_config));
+        WriteSnippets(file_config, "after_includes", generator);
+        
+        for (const auto& ns : file_config.namespaces) {
+            generator.BeginNamespace(ns);
+        }
+        WriteSnippets(file_config, "namespace_begin", generator);
+        
+        for (const auto& func_config : file_config.functions) {
+            generator.GenerateFunction(ConvertToCppFunction(func_config, generator.GetSymbols(), alloc), false);
+        }
+        
+        for (const auto& global_config : file_config.globals) {
+            if (!global_config.comment.empty()) {
+                generator.GetFormatter().AddComment(global_config.comment);
+            }
+            generator.GenerateGlobal(ConvertToCppMember(global_config, generator.GetSymbols()));
+        }
+        
+        for (const auto& class_config : file_config.classes) {
+            generator.GenerateClass(ConvertToCppClass(class_config, generator.GetSymbols(), alloc));
+        }
+        
+        WriteSnippets(file_config, "namespace_end", generator);
+        for (size_t i = 0; i < file_config.namespaces.size(); ++i) {
+            generator.EndNamespace();
+        }
+        
+        generator.EndFile();
+        WriteSnippets(file_config, "end_of_file", generator);
+    }
     
-    size_t start = 0;
-    size_t end = class_code.find('\n');
-    while (end != std::string::npos) {
-        lines.push_back(class_code.substr(start, end - start));
-        start = end + 1;
-        end = class_code.find('\n', start);
+    bool header_ok = CloseOutput(header_output, header_path, header_buffer, error);
+    bool source_ok = CloseOutput(source_output, source_path, source_buffer, error);
+    return header_ok && source_ok;
+}
+
+code_generator::ZeroCopyOutputStreamPtr EnhancedCppGenerator::OpenOutput(const std::string& path, std::string* buffer,
+                                                                       std::string* error) {
+    if (write_if_changed_) {
+        return code_generator::ZeroCopyOutputStreamPtr(new code_generator::StringOutputStream(buffer));
     }
     
-    formatter.Print(lines);
+    try {
+        return code_generator::ZeroCopyOutputStreamPtr(new code_generator::FileOutputStream(path, kOutputBufferSize));
+    } catch (const std::exception& e) {
+        *error = "create Error file:" + path;
+        return code_generator::ZeroCopyOutputStreamPtr();
+    }
+}
+
+bool EnhancedCppGenerator::CloseOutput(code_generator::ZeroCopyOutputStreamPtr output, const std::string& path,
+                                       const std::string& buffer, std::string* error) {
+    if (!write_if_changed_) {
+        if (!output->Flush()) {
+            *error = "write Error file:" + path;
+            return false;
+        }
+        return true;
+    }
     
+    // 内容未变化时保留原文件，不更新修改时间，下游构建不会重新编译
+    std::string existing;
+    if (code_generator::StreamUtil::ReadFileToString(path, &existing) && existing == buffer) {
+        return true;
+    }
+    if (!code_generator::StreamUtil::WriteStringToFile(buffer, path)) {
+        *error = "create Error file:" + path;
+        return false;
+    }
     return true;
 }
 
-bool EnhancedCppGenerator::GenerateFunction(const code_generator::CodeGenConfig::FunctionConfig& func_config, code_generator::Formatter& formatter, bool in_class) {
-    CppFunction cpp_function = ConvertToCppFunction(func_config);
+bool EnhancedCppGenerator::GenerateClass(const code_generator::CodeGenConfig::ClassConfig& class_config, CppGenerator& generator,
+                                         const ModelAllocator& alloc) {
+    generator.GenerateClassDeclaration(ConvertToCppClass(class_config, generator.GetSymbols(), alloc));
+    return true;
+}
+
+bool EnhancedCppGenerator::GenerateFunction(const code_generator::CodeGenConfig::FunctionConfig& func_config, CppGenerator& generator, bool in_class,
+                                            const ModelAllocator& alloc) {
+    CppFunction cpp_function = ConvertToCppFunction(func_config, generator.GetSymbols(), alloc);
     
     if (in_class) {
         // 在类中生成函数声明
+        code_generator::Formatter& formatter = generator.GetFormatter();
         if (config_parser_ && config_parser_->GetProjectConfig().code_templates.count("function_comment")) {
             std::string comment = config_parser_->ApplyTemplate("function_comment", {{"function_name", func_config.name}});
             formatter.AddComment(comment);
         }
         
-        formatter.AddLine(cpp_function.GetSignature() + ";");
+        cpp_function.AppendTo(formatter);
+        formatter.Print(";").EndLine();
     } else {
         // 生成独立函数实现
-        //std::stringstream buffer;
-        std::string buffer;
-        code_generator::ZeroCopyOutputStreamPtr string_output(new code_generator::StringOutputStream(&buffer));
-        
-        CppGeneratorOptions options;
-        options.indent_style = code_generator::Formatter::IndentStyle::SPACES_2;
-        CppGenerator generator(string_output, options);
-        
         generator.GenerateFunctionImplementation(cpp_function);
-        
-        //std::string function_code = buffer.str();
-        std::string function_code = buffer;
-        std::vector<std::string> lines;
-        
-        size_t start = 0;
-        size_t end = function_code.find('\n');
-        while (end != std::string::npos) {
-            lines.push_back(function_code.substr(start, end - start));
-            start = end + 1;
-            end = function_code.find('\n', start);
-        }
-        
-        formatter.Print(lines);
     }
     
     return true;
 }
 
-bool EnhancedCppGenerator::GenerateMember(const code_generator::CodeGenConfig::MemberConfig& member_config, code_generator::Formatter& formatter) {
-    CppMember cpp_member = ConvertToCppMember(member_config);
+bool EnhancedCppGenerator::GenerateMember(const code_generator::CodeGenConfig::MemberConfig& member_config, CppGenerator& generator) {
+    CppMember cpp_member = ConvertToCppMember(member_config, generator.GetSymbols());
+    code_generator::Formatter& formatter = generator.GetFormatter();
     
     if (!member_config.comment.empty()) {
         formatter.AddComment(member_config.comment);
     }
     
-    formatter.AddLine(cpp_member.ToString());
+    cpp_member.AppendTo(formatter);
+    formatter.EndLine();
     return true;
 }
 
@@ -253,10 +753,21 @@ bool EnhancedCppGenerator::GenerateGlobal(const code_generator::CodeGenConfig::M
     return true;
 }
 
-CppClass EnhancedCppGenerator::ConvertToCppClass(const code_generator::CodeGenConfig::ClassConfig& config) {
-    CppClass cpp_class;
+CppClass EnhancedCppGenerator::ConvertToCppClass(const code_generator::CodeGenConfig::ClassConfig& config, SymbolTable& symbols,
+                                                 const ModelAllocator& alloc) {
+    CppClass cpp_class(alloc);
     cpp_class.name = config.name;
-    cpp_class.base_classes = config.base_classes;
+    cpp_class.base_classes.assign(config.base_classes.begin(), config.base_classes.end());
+    
+    // 节点直接在类的容器中构造
+    cpp_class.functions.reserve(config.functions.size());
+    for (const auto& func_config : config.functions) {
+        BuildCppFunction(func_config, symbols, &cpp_class.EmplaceFunction());
+    }
+    cpp_class.members.reserve(config.members.size());
+    for (const auto& member_config : config.members) {
+        BuildCppMember(member_config, symbols, &cpp_class.EmplaceMember());
+    }
     
     // 这里可以添加从模板生成成员和函数的逻辑
     for (const auto& template_name : config.templates) {
@@ -268,62 +779,69 @@ CppClass EnhancedCppGenerator::ConvertToCppClass(const code_generator::CodeGenCo
     return cpp_class;
 }
 
-CppFunction EnhancedCppGenerator::ConvertToCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config) {
-    CppFunction cpp_function;
-    cpp_function.name = config.name;
-    cpp_function.return_type = config.return_type;
-    cpp_function.is_virtual = config.is_virtual;
-    cpp_function.is_pure_virtual = config.is_pure_virtual;
-    cpp_function.is_const = config.is_const;
-    cpp_function.is_static = config.is_static;
-    cpp_function.access_specifier = config.access;
-    cpp_function.body = ProcessCodeBody(config.body);
-    
-    //for (const auto& [type, name] : config.parameters) {
-    for (const auto& iter : config.parameters) {
-        const std::string& type = iter.first;
-        const std::string& name = iter.second;
-        CppParameter param;
-        param.type.name = type;
-        param.name = name;
-        cpp_function.parameters.push_back(param);
-    }
-    
+CppFunction EnhancedCppGenerator::ConvertToCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config, SymbolTable& symbols,
+                                                       const ModelAllocator& alloc) {
+    CppFunction cpp_function(alloc);
+    BuildCppFunction(config, symbols, &cpp_function);
     return cpp_function;
 }
 
-CppMember EnhancedCppGenerator::ConvertToCppMember(const code_generator::CodeGenConfig::MemberConfig& config) {
+CppMember EnhancedCppGenerator::ConvertToCppMember(const code_generator::CodeGenConfig::MemberConfig& config, SymbolTable& symbols) {
     CppMember cpp_member;
-    cpp_member.type.name = config.type;
-    cpp_member.name = config.name;
-    cpp_member.initializer = config.initializer;
+    BuildCppMember(config, symbols, &cpp_member);
     return cpp_member;
 }
 
+void EnhancedCppGenerator::BuildCppFunction(const code_generator::CodeGenConfig::FunctionConfig& config, SymbolTable& symbols,
+                                            CppFunction* function) {
+    function->name = config.name;
+    function->return_type = symbols.Intern(config.return_type);
+    function->is_virtual = config.is_virtual;
+    function->is_pure_virtual = config.is_pure_virtual;
+    function->is_const = config.is_const;
+    function->is_static = config.is_static;
+    function->access_specifier = ParseAccessSpecifier(config.access, AccessSpecifier::PUBLIC);
+    function->body = ProcessCodeBody(config.body, "function " + config.name);
+    
+    function->parameters.reserve(config.parameters.size());
+    for (const auto& iter : config.parameters) {
+        function->AddParameter(symbols.Intern(iter.first), iter.second);
+    }
+}
+
+void EnhancedCppGenerator::BuildCppMember(const code_generator::CodeGenConfig::MemberConfig& config, SymbolTable& symbols,
+                                          CppMember* member) {
+    member->type.name = symbols.Intern(config.type);
+    member->name = config.name;
+    member->initializer = config.initializer;
+    member->access_specifier = ParseAccessSpecifier(config.access, AccessSpecifier::PRIVATE);
+}
+
+std::vector<std::string> EnhancedCppGenerator::CollectIncludes(const code_generator::CodeGenConfig::FileConfig& file_config) const {
+    std::vector<std::string> includes = file_config.includes;
+    
+    // 添加公共包含
+    if (config_parser_) {
+        const auto& project_config = config_parser_->GetProjectConfig();
+        includes.insert(includes.end(), project_config.common_includes.begin(), project_config.common_includes.end());
+    }
+    return includes;
+}
+
 void EnhancedCppGenerator::RegisterTemplate(const std::string& name, const std::string& content) {
-    custom_templates_[name] = content;
+    // 注册时编译一次，应用时单遍展开
+    custom_templates_[name] = CompiledTemplate(content);
+    include_expander_->ClearCache();
 }
 
 std::string EnhancedCppGenerator::ApplyTemplate(const std::string& template_name, const std::map<std::string, std::string>& variables) {
     // 首先查找自定义模板
     auto custom_it = custom_templates_.find(template_name);
     if (custom_it != custom_templates_.end()) {
-        std::string result = custom_it->second;
-        
         // 替换变量
-        //for (const auto& [key, value] : variables) {
-        for (const auto& iter : variables) {
-            const std::string& key = iter.first;
-            const std::string& value = iter.second;
-            std::string placeholder = "${" + key + "}";
-            size_t pos = 0;
-            while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-                result.replace(pos, placeholder.length(), value);
-                pos += value.length();
-            }
-        }
-        
-        return result;
+        VariableTable table(variables);
+        const json::object* data = config_parser_ ? &config_parser_->GetProjectConfig().structured_variables : nullptr;
+        return custom_it->second.Render({&table}, data);
     }
     
     // 然后查找配置中的模板
@@ -382,39 +900,79 @@ bool EnhancedCppGenerator::EnsureDirectory(const std::string& path) {
 
 void EnhancedCppGenerator::AddCodeLibrary(const std::string& name, const std::string& path) {
     code_libraries_[name] = path;
+    include_expander_->ClearCache();
 }
 
 std::string EnhancedCppGenerator::ResolveCodeReference(const std::string& reference) {
+    IncludeExpander::Resolved resolved = ResolveCodeReferenceText(reference);
+    return std::string(resolved.text.data(), resolved.text.size());
+}
+
+IncludeExpander::Resolved EnhancedCppGenerator::ResolveCodeReferenceText(const std::string& reference) {
+    IncludeExpander::Resolved resolved;
     // 检查是否是代码库引用格式: library::component
     size_t pos = reference.find("::");
     if (pos != std::string::npos) {
-        std::string library = reference.substr(0, pos);
-        std::string component = reference.substr(pos + 2);
-        
-        auto it = code_libraries_.find(library);
+        auto it = code_libraries_.find(boost::string_view(reference.data(), pos));
         if (it != code_libraries_.end()) {
-            std::string library_path = it->second;
-            std::string file_path = library_path + "/" + component;
+            std::string file_path = it->second;
+            file_path += '/';
+            file_path.append(reference, pos + 2, std::string::npos);
             
-            // 尝试读取文件
-            std::ifstream file(file_path);
-            if (file) {
-                std::stringstream buffer;
-                buffer << file.rdbuf();
-                return buffer.str();
+            // 库文件映射后常驻缓存，同一文件只打开一次；结果直接指向映射内容，由holder保持映射有效
+            CodeLibraryCache::Content content = library_cache_->Get(file_path);
+            if (content) {
+                resolved.text = content->view();
+                resolved.holder = content;
+                return resolved;
             }
         }
     }
     
     // 如果不是代码库引用，尝试作为模板处理
-    return ApplyTemplate(reference);
+    std::shared_ptr<std::string> text = std::make_shared<std::string>(ApplyTemplate(reference));
+    resolved.text = *text;
+    resolved.holder = text;
+    return resolved;
+}
+
+bool EnhancedCppGenerator::CheckCodeReference(const std::string& reference, std::string* reason) const {
+    size_t pos = reference.find("::");
+    std::string missing_path;
+    if (pos != std::string::npos) {
+        auto it = code_libraries_.find(boost::string_view(reference.data(), pos));
+        if (it != code_libraries_.end()) {
+            std::string file_path = it->second;
+            file_path += '/';
+            file_path.append(reference, pos + 2, std::string::npos);
+            boost::system::error_code ec;
+            if (boost::filesystem::is_regular_file(file_path, ec)) {
+                return true;
+            }
+            missing_path = file_path;
+        }
+    }
+    
+    // 代码库中找不到时与ResolveCodeReference一样按模板名查找
+    if (custom_templates_.find(reference) != custom_templates_.end() ||
+        (config_parser_ && config_parser_->GetCompiledTemplate(reference))) {
+        return true;
+    }
+    if (!missing_path.empty()) {
+        *reason = "missing library component " + missing_path;
+    } else if (pos != std::string::npos) {
+        *reason = "unknown code library " + reference.substr(0, pos);
+    } else {
+        *reason = "no such template";
+    }
+    return false;
 }
 
-std::string EnhancedCppGenerator::ProcessCodeBody(const std::string& body) {
-    std::string processed = body;
+std::string EnhancedCppGenerator::ProcessCodeBody(const std::string& body, const std::string& source_name) {
+    std::string processed;
     
     // 解析关键字和引用
-    processed = ResolveKeywords(processed);
+    processed = ResolveKeywords(body, source_name);
     
     // 变量替换
     if (config_parser_) {
@@ -424,23 +982,19 @@ std::string EnhancedCppGenerator::ProcessCodeBody(const std::string& body) {
     return processed;
 }
 
-std::string EnhancedCppGenerator::ResolveKeywords(const std::string& text) {
-    std::string result = text;
-    
+std::string EnhancedCppGenerator::ResolveKeywords(const std::string& text, const std::string& source_name) {
     // 处理特殊关键字
-    // 例如: @include(library::component)
-    size_t start_pos = 0;
-    while ((start_pos = result.find("@include(", start_pos)) != std::string::npos) {
-        size_t end_pos = result.find(")", start_pos);
-        if (end_pos == std::string::npos) break;
-        
-        std::string reference = result.substr(start_pos + 9, end_pos - start_pos - 9);
-        std::string resolved_code = ResolveCodeReference(reference);
-        
-        result.replace(start_pos, end_pos - start_pos + 1, resolved_code);
-        start_pos += resolved_code.length();
+    // 例如: @include(library::component)，被引用内容中的@include递归展开
+    if (text.find("@include(") == std::string::npos) {
+        return text;
     }
     
+    std::string result;
+    result.reserve(text.size());
+    std::string error;
+    if (!include_expander_->Expand(text, source_name, &result, &error)) {
+        throw std::runtime_error(error);
+    }
     return result;
 }
 
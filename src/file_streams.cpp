@@ -61,7 +61,7 @@ std::int64_t FileOutputStream::ByteCount() const {
 }
 
 bool FileOutputStream::Flush() {
-    return FlushBuffer();
+    return FlushBuffer() && fflush(file_) == 0;
 }
 
 bool FileOutputStream::FlushBuffer() {
@@ -72,8 +72,6 @@ bool FileOutputStream::FlushBuffer() {
         }
         total_bytes_ += buffer_offset_;
         buffer_offset_ = 0;
-        
-        return fflush(file_) == 0;
     }
     return true;
 }
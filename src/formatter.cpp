@@ -1,5 +1,6 @@
 #include "code_generator/formatter.h"
 #include <boost/algorithm/string/join.hpp>
+#include <cstring>
 
 namespace code_generator {
 
@@ -25,7 +26,20 @@ Formatter& Formatter::Print(const std::string& text) {
 }
 
 Formatter& Formatter::Print(const char* text) {
-	return Print(std::string(text));
+	return Print(text, strlen(text));
+}
+
+Formatter& Formatter::Print(const char* data, size_t size) {
+	if (size == 0) return *this;
+
+	if (at_start_of_line_) {
+		WriteIndent();
+		at_start_of_line_ = false;
+	}
+
+	// 直接写入输出流窗口，不构造临时字符串
+	output_->WriteRaw(data, static_cast<int>(size));
+	return *this;
 }
 
 Formatter& Formatter::Print(int value) {
@@ -39,6 +53,18 @@ Formatter& Formatter::Print(const std::vector<std::string>& lines) {
 	return *this;
 }
 
+Formatter& Formatter::Raw(const std::string& text) {
+	return Raw(text.data(), text.size());
+}
+
+Formatter& Formatter::Raw(const char* data, size_t size) {
+	if (size == 0) return *this;
+
+	output_->WriteRaw(data, static_cast<int>(size));
+	at_start_of_line_ = data[size - 1] == '\n';
+	return *this;
+}
+
 Formatter& Formatter::Indent() {
 	++indent_level_;
 	return *this;
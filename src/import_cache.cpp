@@ -0,0 +1,77 @@
+#include "code_generator/import_cache.h"
+#include "code_generator/binary_config.h"
+#include "code_generator/build_manifest.h"
+#include "code_generator/code_library_cache.h"
+#include <boost/filesystem.hpp>
+
+namespace code_generator {
+
+ImportCache& ImportCache::Instance() {
+	static ImportCache cache;
+	return cache;
+}
+
+ImportCache::Document ImportCache::Get(const std::string& path, std::string* error) {
+	boost::system::error_code ec;
+	int64_t mtime = static_cast<int64_t>(boost::filesystem::last_write_time(path, ec));
+	uint64_t size = ec ? 0 : boost::filesystem::file_size(path, ec);
+	if (ec) {
+		*error = "Cannot read import file: " + path;
+		return Document();
+	}
+
+	std::shared_ptr<Entry> entry;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::shared_ptr<Entry>& slot = entries_[path];
+		if (!slot || slot->mtime != mtime || slot->size != size) {
+			slot = std::make_shared<Entry>();
+			slot->mtime = mtime;
+			slot->size = size;
+		}
+		entry = slot;
+	}
+
+	// 在锁外解析，其他文件的查找不受影响；同一文件的并发请求等待第一次解析完成
+	std::call_once(entry->once, &ImportCache::Parse, path, entry.get());
+	if (!entry->document) {
+		*error = entry->error;
+	}
+	return entry->document;
+}
+
+void ImportCache::Parse(const std::string& path, Entry* entry) {
+	try {
+		MappedFile mapped(path);
+		// 文档在独立的内存池中分配，与缓存项一起释放
+		boost::json::storage_ptr arena =
+				boost::json::make_shared_resource<boost::json::monotonic_resource>(mapped.size() * 2 + 4096);
+		std::shared_ptr<ImportedDocument> document = std::make_shared<ImportedDocument>(arena);
+		document->path = path;
+		document->fingerprint = Fingerprint().Update(mapped.data(), mapped.size()).Value();
+		// 被导入的文件同样可以是CBOR或MessagePack
+		if (!BinaryConfigCodec::Parse(mapped.data(), mapped.size(), &document->value, &entry->error)) {
+			entry->error = "Import file " + path + " parsing error: " + entry->error;
+			return;
+		}
+		if (!document->value.is_object()) {
+			entry->error = "Import file is not a JSON object: " + path;
+			return;
+		}
+		entry->document = document;
+	} catch (const std::exception& e) {
+		entry->error = "Import file " + path + " parsing error: " + e.what();
+	}
+}
+
+size_t ImportCache::Size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+void ImportCache::Clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+}
+
+} // namespace code_generator
@@ -0,0 +1,125 @@
+#include "code_generator/include_expander.h"
+#include <algorithm>
+#include <cstring>
+
+namespace code_generator {
+
+namespace {
+
+const char kIncludeToken[] = "@include(";
+const size_t kIncludeTokenSize = sizeof(kIncludeToken) - 1;
+
+} // namespace
+
+IncludeExpander::IncludeExpander(Resolver resolver, int max_depth)
+		: resolver_(std::move(resolver)), max_depth_(max_depth) {
+}
+
+bool IncludeExpander::Expand(const std::string& text, const std::string& source_name,
+							 std::string* output, std::string* error) {
+	std::vector<std::string> chain;
+	return ExpandText(text.data(), text.size(), source_name, &chain, output, error);
+}
+
+bool IncludeExpander::ExpandReference(const std::string& reference, std::string* output, std::string* error) {
+	std::vector<std::string> chain;
+	Expanded expanded = ExpandReference(reference, &chain, error);
+	if (!expanded) {
+		return false;
+	}
+	output->append(*expanded);
+	return true;
+}
+
+void IncludeExpander::ClearCache() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	cache_.clear();
+}
+
+bool IncludeExpander::ExpandText(const char* data, size_t size, const std::string& source_name,
+								 std::vector<std::string>* chain, std::string* output, std::string* error) {
+	const char* end = data + size;
+	const char* pos = data;
+	// 行列号随扫描增量计算，只在出错时使用
+	int line = 1;
+	const char* line_start = data;
+
+	while (pos < end) {
+		const char* found = std::search(pos, end, kIncludeToken, kIncludeToken + kIncludeTokenSize);
+		for (const char* p = pos; p < found; ++p) {
+			if (*p == '\n') {
+				++line;
+				line_start = p + 1;
+			}
+		}
+		output->append(pos, found);
+		if (found == end) {
+			break;
+		}
+
+		const char* ref_begin = found + kIncludeTokenSize;
+		const char* ref_end = std::find(ref_begin, end, ')');
+		if (ref_end == end) {
+			// 没有右括号，原样保留
+			output->append(found, end);
+			break;
+		}
+
+		std::string reference(ref_begin, ref_end);
+		Expanded expanded = ExpandReference(reference, chain, error);
+		if (!expanded) {
+			*error = source_name + ":" + std::to_string(line) + ":" +
+					 std::to_string(found - line_start + 1) + ": " + *error;
+			return false;
+		}
+		output->append(*expanded);
+		pos = ref_end + 1;
+	}
+	return true;
+}
+
+IncludeExpander::Expanded IncludeExpander::ExpandReference(const std::string& reference,
+														   std::vector<std::string>* chain,
+														   std::string* error) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = cache_.find(reference);
+		if (it != cache_.end()) {
+			return it->second;
+		}
+	}
+
+	if (std::find(chain->begin(), chain->end(), reference) != chain->end()) {
+		*error = "cyclic @include: " + FormatChain(*chain, reference);
+		return Expanded();
+	}
+	if (static_cast<int>(chain->size()) >= max_depth_) {
+		*error = "@include nesting exceeds " + std::to_string(max_depth_) + ": " + FormatChain(*chain, reference);
+		return Expanded();
+	}
+
+	Resolved resolved = resolver_(reference);
+	std::shared_ptr<std::string> result = std::make_shared<std::string>();
+	result->reserve(resolved.text.size());
+
+	chain->push_back(reference);
+	bool ok = ExpandText(resolved.text.data(), resolved.text.size(), reference, chain, result.get(), error);
+	chain->pop_back();
+	if (!ok) {
+		return Expanded();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	// 并发展开同一引用时保留先写入的结果，内容相同
+	return cache_.emplace(reference, result).first->second;
+}
+
+std::string IncludeExpander::FormatChain(const std::vector<std::string>& chain, const std::string& last) {
+	std::string text;
+	for (const auto& reference : chain) {
+		text += reference + " -> ";
+	}
+	return text + last;
+}
+
+} // namespace code_generator
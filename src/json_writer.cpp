@@ -0,0 +1,229 @@
+#include "code_generator/json_writer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace code_generator {
+
+JsonWriter::JsonWriter(ZeroCopyOutputStream* output, bool pretty, int indent)
+	: output_(output), pretty_(pretty), indent_(indent) {
+}
+
+JsonWriter::~JsonWriter() {
+	Flush();
+}
+
+void JsonWriter::BeginObject() {
+	Open('{');
+}
+
+void JsonWriter::EndObject() {
+	Close('}');
+}
+
+void JsonWriter::BeginArray() {
+	Open('[');
+}
+
+void JsonWriter::EndArray() {
+	Close(']');
+}
+
+void JsonWriter::Key(const char* data, size_t size) {
+	BeforeValue();
+	WriteEscaped(data, size);
+	if (pretty_) {
+		Write(": ", 2);
+	} else {
+		Put(':');
+	}
+	after_key_ = true;
+}
+
+void JsonWriter::String(const char* data, size_t size) {
+	BeforeValue();
+	WriteEscaped(data, size);
+}
+
+void JsonWriter::Bool(bool value) {
+	BeforeValue();
+	if (value) {
+		Write("true", 4);
+	} else {
+		Write("false", 5);
+	}
+}
+
+void JsonWriter::Null() {
+	BeforeValue();
+	Write("null", 4);
+}
+
+void JsonWriter::Value(const boost::json::value& value) {
+	if (const boost::json::object* object = value.if_object()) {
+		BeginObject();
+		for (const auto& iter : *object) {
+			Key(iter.key().data(), iter.key().size());
+			Value(iter.value());
+		}
+		EndObject();
+	} else if (const boost::json::array* array = value.if_array()) {
+		BeginArray();
+		for (const auto& item : *array) {
+			Value(item);
+		}
+		EndArray();
+	} else if (const boost::json::string* text = value.if_string()) {
+		String(text->data(), text->size());
+	} else if (value.is_bool()) {
+		Bool(value.as_bool());
+	} else if (value.is_null()) {
+		Null();
+	} else {
+		// 数字的格式与json::serialize保持一致
+		BeforeValue();
+		std::string number = boost::json::serialize(value);
+		Write(number.data(), number.size());
+	}
+}
+
+void JsonWriter::StringArray(const std::vector<std::string>& values) {
+	BeginArray();
+	for (const auto& value : values) {
+		String(value);
+	}
+	EndArray();
+}
+
+bool JsonWriter::Flush() {
+	if (available_ > 0) {
+		output_->BackUp(available_);
+		available_ = 0;
+		buffer_ = nullptr;
+	}
+	return !error_;
+}
+
+void JsonWriter::BeforeValue() {
+	if (after_key_) {
+		after_key_ = false;
+		return;
+	}
+	if (levels_.empty()) {
+		return;
+	}
+	Level& level = levels_.back();
+	if (!level.empty) {
+		Put(',');
+	}
+	level.empty = false;
+	NewLine();
+}
+
+void JsonWriter::NewLine() {
+	if (!pretty_) {
+		return;
+	}
+	Put('\n');
+	for (size_t i = levels_.size() * indent_; i > 0; --i) {
+		Put(' ');
+	}
+}
+
+void JsonWriter::Open(char token) {
+	BeforeValue();
+	Put(token);
+	Level level = { true };
+	levels_.push_back(level);
+}
+
+void JsonWriter::Close(char token) {
+	bool empty = levels_.empty() || levels_.back().empty;
+	if (!levels_.empty()) {
+		levels_.pop_back();
+	}
+	if (!empty) {
+		NewLine();
+	}
+	Put(token);
+}
+
+void JsonWriter::WriteEscaped(const char* data, size_t size) {
+	static const char kHex[] = "0123456789abcdef";
+
+	Put('"');
+	// 不需要转义的连续字符整段写入
+	size_t begin = 0;
+	for (size_t i = 0; i < size; ++i) {
+		unsigned char c = static_cast<unsigned char>(data[i]);
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+		Write(data + begin, i - begin);
+		begin = i + 1;
+
+		char escaped[6] = { '\\', 0, 0, 0, 0, 0 };
+		size_t length = 2;
+		switch (c) {
+		case '"': escaped[1] = '"'; break;
+		case '\\': escaped[1] = '\\'; break;
+		case '\b': escaped[1] = 'b'; break;
+		case '\f': escaped[1] = 'f'; break;
+		case '\n': escaped[1] = 'n'; break;
+		case '\r': escaped[1] = 'r'; break;
+		case '\t': escaped[1] = 't'; break;
+		default:
+			escaped[1] = 'u';
+			escaped[2] = '0';
+			escaped[3] = '0';
+			escaped[4] = kHex[c >> 4];
+			escaped[5] = kHex[c & 0xf];
+			length = 6;
+			break;
+		}
+		Write(escaped, length);
+	}
+	Write(data + begin, size - begin);
+	Put('"');
+}
+
+void JsonWriter::Write(const char* data, size_t size) {
+	while (size > 0) {
+		if (available_ == 0 && !NextBuffer()) {
+			return;
+		}
+		size_t count = std::min(size, static_cast<size_t>(available_));
+		memcpy(buffer_, data, count);
+		buffer_ += count;
+		available_ -= static_cast<int>(count);
+		data += count;
+		size -= count;
+	}
+}
+
+void JsonWriter::Put(char c) {
+	if (available_ == 0 && !NextBuffer()) {
+		return;
+	}
+	*buffer_++ = c;
+	--available_;
+}
+
+bool JsonWriter::NextBuffer() {
+	if (error_) {
+		return false;
+	}
+	void* data = nullptr;
+	int size = 0;
+	// 输出流可能返回空窗口，继续请求直到拿到可写空间
+	while (size == 0) {
+		if (!output_->Next(&data, &size)) {
+			error_ = true;
+			return false;
+		}
+	}
+	buffer_ = static_cast<char*>(data);
+	available_ = size;
+	return true;
+}
+
+} // namespace code_generator
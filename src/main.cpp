@@ -1,6 +1,7 @@
 // src/main.cpp - 简化版主程序
 #include "code_generator.h"
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <iostream>
 
 namespace po = boost::program_options;
@@ -106,6 +107,17 @@ int main(int argc, char* argv[]) {
             ("output,o", po::value<std::string>()->default_value("./generated"), "Output directory")
             ("template,t", po::value<std::string>(), "Template name")
             ("list-templates,l", "List available templates")
+            ("incremental", "Skip files whose inputs are unchanged since the last run")
+            ("write-if-changed", "Only rewrite generated files whose content changed")
+            ("config-cache", po::value<std::string>(), "Cache compiled configs in this directory and skip JSON parsing for unchanged configs")
+            ("validate", "Check the configs and report every problem without generating any files")
+            ("stream", "Parse the config incrementally and generate files while parsing (for very large configs)")
+            ("model-arena", "Build each file's code model in a memory arena released in one step after the file is written")
+            ("compile-templates", po::value<std::string>(), "Write native C++ renderers for the configs' code_templates into this directory")
+            ("template-plugin", po::value<std::vector<std::string>>()->multitoken(), "Load compiled template plugins before generating")
+            ("generate-config-json", po::value<std::string>(), "Regenerate the config FromJson/ToJson source from the built-in schema into this file")
+            ("convert", po::value<std::vector<std::string>>()->multitoken(), "Convert a config file between JSON, CBOR and MessagePack: --convert INPUT OUTPUT (format from OUTPUT extension)")
+            ("jobs,j", po::value<int>()->default_value(1), "Number of parallel jobs for configs and files (0 = hardware concurrency)")
             ("verbose", "Verbose output");
 
         po::variables_map vm;
@@ -141,13 +153,97 @@ int main(int argc, char* argv[]) {
             return 0;
         }
 
+        if (vm.count("generate-config-json")) {
+            // 生成的源码随仓库提交，修改CodeGenConfig后用regenerate_config_json目标更新
+            std::string error;
+            code_generator::ConfigSchemaCompiler compiler(code_generator::GetConfigSchema());
+            if (!compiler.WriteFile(vm["generate-config-json"].as<std::string>(), &error)) {
+                std::cerr << "Failed to generate config json source: " << error << std::endl;
+                return 1;
+            }
+            std::cout << "Generated " << vm["generate-config-json"].as<std::string>() << std::endl;
+            return 0;
+        }
+
+        if (vm.count("convert")) {
+            // 输入格式按内容识别，输出格式由扩展名.json/.cbor/.msgpack决定
+            const std::vector<std::string>& paths = vm["convert"].as<std::vector<std::string>>();
+            if (paths.size() != 2) {
+                std::cerr << "--convert requires INPUT and OUTPUT" << std::endl;
+                return 1;
+            }
+            std::string error;
+            if (!code_generator::BinaryConfigCodec::ConvertFile(paths[0], paths[1], &error)) {
+                std::cerr << "Failed to convert config: " << error << std::endl;
+                return 1;
+            }
+            std::cout << "Converted " << paths[0] << " -> " << paths[1] << std::endl;
+            return 0;
+        }
+
+        if (vm.count("template-plugin")) {
+            for (const auto& plugin : vm["template-plugin"].as<std::vector<std::string>>()) {
+                std::string error;
+                if (!code_generator::NativeTemplateRegistry::Instance().LoadPlugin(plugin, &error)) {
+                    std::cerr << "Failed to load template plugin " << error << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        if (vm.count("compile-templates")) {
+            if (!vm.count("config")) {
+                std::cerr << "--compile-templates requires --config" << std::endl;
+                return 1;
+            }
+            // 各配置中的code_templates合并生成一份源码，同名模板以先出现的为准
+            code_generator::NativeTemplateCompiler compiler;
+            for (const auto& config : vm["config"].as<std::vector<std::string>>()) {
+                code_generator::ConfigParser parser;
+                if (!parser.LoadFromFile(config)) {
+                    std::cerr << "load from file: " << config << ". Error:" << parser.GetError() << std::endl;
+                    return 1;
+                }
+                for (const auto& iter : parser.GetProjectConfig().code_templates) {
+                    std::string reason;
+                    if (!compiler.AddTemplate(iter.first, iter.second, &reason)) {
+                        std::cout << "Skip template " << iter.first << " (" << config << "): " << reason << std::endl;
+                    }
+                }
+            }
+            std::string error;
+            if (!compiler.WriteFiles(vm["compile-templates"].as<std::string>(), "native_templates", &error)) {
+                std::cerr << "Failed to compile templates: " << error << std::endl;
+                return 1;
+            }
+            std::cout << "Compiled " << compiler.Size() << " templates into "
+                      << vm["compile-templates"].as<std::string>() << std::endl;
+            return 0;
+        }
+
         // 这里可以添加主要的代码生成逻辑
         if (vm.count("config")) {
             auto configs = vm["config"].as<std::vector<std::string>>();
-            for (auto config : configs) {
-                code_generator::EnhancedCppGenerator ecg;
-                bool ret = ecg.GenerateFromConfigFile(config);
-                std::cout << "config file:(" << ret << ")" << config << std::endl;
+            int jobs = std::max(0, vm["jobs"].as<int>());
+            // 所有配置共享一个线程池并发生成，结果按参数顺序输出
+            code_generator::ProjectScheduler scheduler(jobs);
+            scheduler.SetIncremental(vm.count("incremental") > 0);
+            scheduler.SetWriteIfChanged(vm.count("write-if-changed") > 0);
+            scheduler.SetStreaming(vm.count("stream") > 0);
+            scheduler.SetValidateOnly(vm.count("validate") > 0);
+            scheduler.SetUseModelArena(vm.count("model-arena") > 0);
+            if (vm.count("config-cache")) {
+                scheduler.SetConfigCacheDirectory(vm["config-cache"].as<std::string>());
+            }
+            for (const auto& config : configs) {
+                scheduler.AddConfig(config);
+            }
+            bool succeeded = scheduler.Run();
+            scheduler.PrintResults(std::cout);
+            scheduler.PrintSummary(std::cout);
+            if (vm.count("validate")) {
+                // 校验模式以退出码给出结果，便于在CI中使用
+                return succeeded ? 0 : 1;
             }
         }
 
@@ -0,0 +1,409 @@
+#include "code_generator/native_template.h"
+#include "code_generator/build_manifest.h"
+#include "code_generator/file_streams.h"
+#include <boost/dll/shared_library.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <set>
+
+namespace code_generator {
+
+namespace {
+
+typedef const NativeTemplateEntry* (*NativeTemplatesFunction)(size_t* count);
+
+const char* const kCppKeywords[] = {
+	"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case",
+	"catch", "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr", "const_cast",
+	"continue", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+	"explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+	"long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+	"or_eq", "private", "protected", "public", "register", "reinterpret_cast", "return", "short",
+	"signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template",
+	"this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+	"unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"
+};
+
+bool IsCppKeyword(const std::string& word) {
+	for (const char* keyword : kCppKeywords) {
+		if (word == keyword) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// 名称冲突时追加序号
+std::string MakeUnique(const std::string& identifier, std::set<std::string>* used) {
+	std::string result = identifier;
+	for (int i = 2; !used->insert(result).second; ++i) {
+		result = identifier + "_" + std::to_string(i);
+	}
+	return result;
+}
+
+} // namespace
+
+NativeTemplateRegistry& NativeTemplateRegistry::Instance() {
+	static NativeTemplateRegistry registry;
+	return registry;
+}
+
+void NativeTemplateRegistry::Register(const NativeTemplateEntry& entry) {
+	if (!entry.name || !entry.source_hash || !entry.renderer) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	Registration& registration = templates_[entry.name];
+	registration.source_hash = entry.source_hash;
+	registration.renderer = entry.renderer;
+}
+
+void NativeTemplateRegistry::Register(const NativeTemplateEntry* entries, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		Register(entries[i]);
+	}
+}
+
+NativeTemplateRenderer NativeTemplateRegistry::Find(const std::string& name, const std::string& source_text) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = templates_.find(name);
+	if (it == templates_.end() || it->second.source_hash != SourceHash(source_text)) {
+		return nullptr;
+	}
+	return it->second.renderer;
+}
+
+bool NativeTemplateRegistry::LoadPlugin(const boost::filesystem::path& path, std::string* error) {
+	std::shared_ptr<boost::dll::shared_library> library;
+	NativeTemplatesFunction entry_point = nullptr;
+	try {
+		library = std::make_shared<boost::dll::shared_library>(path.string());
+		if (!library->has(CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL)) {
+			*error = path.string() + ": missing symbol " CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL;
+			return false;
+		}
+		entry_point = library->get<const NativeTemplateEntry*(size_t*)>(CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL);
+	} catch (const std::exception& e) {
+		*error = path.string() + ": " + e.what();
+		return false;
+	}
+
+	size_t count = 0;
+	const NativeTemplateEntry* entries = entry_point(&count);
+	Register(entries, count);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	plugins_.push_back(library);
+	return true;
+}
+
+size_t NativeTemplateRegistry::Size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return templates_.size();
+}
+
+std::string NativeTemplateRegistry::SourceHash(const std::string& source_text) {
+	return Fingerprint().Update(BuildManifest::kGeneratorVersion).Update(source_text).ToHex();
+}
+
+boost::string_view NativeTemplateLookup(std::initializer_list<const VariableTable*> tables,
+										boost::string_view name, boost::string_view placeholder) {
+	for (const VariableTable* table : tables) {
+		if (!table) {
+			continue;
+		}
+		const std::string* value = table->Find(name);
+		if (value) {
+			return *value;
+		}
+	}
+	return placeholder;
+}
+
+bool NativeTemplateCompiler::AddTemplate(const std::string& name, const std::string& text, std::string* reason) {
+	CompiledTemplate compiled(text);
+	if (!compiled.Ok()) {
+		*reason = compiled.GetError();
+		return false;
+	}
+	if (compiled.has_sections_) {
+		*reason = "uses {{#each}}/{{#if}} sections";
+		return false;
+	}
+
+	std::set<std::string> used_identifiers;
+	for (const auto& existing : templates_) {
+		if (existing.name == name) {
+			*reason = "duplicate template name";
+			return false;
+		}
+		used_identifiers.insert(existing.identifier);
+	}
+
+	Template tmpl;
+	tmpl.name = name;
+	tmpl.identifier = MakeUnique(ToIdentifier(name, true), &used_identifiers);
+	tmpl.source_hash = NativeTemplateRegistry::SourceHash(text);
+	tmpl.literal_size = 0;
+
+	std::set<std::string> used_members;
+	std::map<std::string, size_t> variable_index;
+	for (const auto& instruction : compiled.program_) {
+		if (instruction.op == CompiledTemplate::OpCode::LITERAL) {
+			std::string literal = compiled.text_.substr(instruction.offset, instruction.length);
+			tmpl.literal_size += literal.size();
+			if (!tmpl.segments.empty() && !tmpl.segments.back().is_variable) {
+				tmpl.segments.back().text += literal;
+			} else {
+				Segment segment = { false, literal, 0 };
+				tmpl.segments.push_back(segment);
+			}
+			continue;
+		}
+
+		std::string variable_name = compiled.text_.substr(instruction.offset, instruction.length);
+		auto it = variable_index.find(variable_name);
+		if (it == variable_index.end()) {
+			Variable variable = { variable_name, MakeUnique(ToIdentifier(variable_name, false), &used_members) };
+			it = variable_index.emplace(variable_name, tmpl.variables.size()).first;
+			tmpl.variables.push_back(variable);
+		}
+		Segment segment = { true, std::string(), it->second };
+		tmpl.segments.push_back(segment);
+	}
+
+	templates_.push_back(tmpl);
+	return true;
+}
+
+bool NativeTemplateCompiler::WriteFiles(const boost::filesystem::path& output_dir, const std::string& basename,
+										std::string* error) const {
+	if (templates_.empty()) {
+		*error = "no templates to compile";
+		return false;
+	}
+
+	boost::filesystem::path header_path = output_dir / (basename + ".h");
+	boost::filesystem::path source_path = output_dir / (basename + ".cpp");
+	// 文件打不开时FileOutputStream的构造函数抛出异常
+	boost::shared_ptr<FileOutputStream> header;
+	boost::shared_ptr<FileOutputStream> source;
+	try {
+		boost::filesystem::create_directories(output_dir);
+		header.reset(new FileOutputStream(header_path));
+		source.reset(new FileOutputStream(source_path));
+	} catch (const std::exception& e) {
+		*error = e.what();
+		return false;
+	}
+
+	{
+		Formatter formatter(header, Formatter::IndentStyle::SPACES_4);
+		WriteHeader(formatter, ToIdentifier(basename, false) + "_H");
+	}
+	if (!header->Flush()) {
+		*error = "Cannot write " + header_path.string();
+		return false;
+	}
+	{
+		Formatter formatter(source, Formatter::IndentStyle::SPACES_4);
+		WriteSource(formatter, basename + ".h");
+	}
+	if (!source->Flush()) {
+		*error = "Cannot write " + source_path.string();
+		return false;
+	}
+	return true;
+}
+
+void NativeTemplateCompiler::WriteHeader(Formatter& formatter, const std::string& guard) const {
+	std::string upper_guard = guard;
+	std::transform(upper_guard.begin(), upper_guard.end(), upper_guard.begin(), ::toupper);
+
+	formatter.AddComment("由cppcodegen --compile-templates生成，请勿手工修改");
+	formatter.IfNDef(upper_guard);
+	formatter.Define(upper_guard);
+	formatter.EndLine();
+	formatter.Include("\"code_generator/native_template.h\"");
+	formatter.Include("<boost/utility/string_view.hpp>");
+	formatter.Include("<string>");
+	formatter.EndLine();
+
+	formatter.Namespace("code_generator");
+	formatter.Namespace("native_templates");
+	for (const auto& tmpl : templates_) {
+		formatter.AddComment(tmpl.name);
+		formatter.Struct(tmpl.identifier + "Variables");
+		for (const auto& variable : tmpl.variables) {
+			formatter.AddLine("boost::string_view " + variable.member + ";");
+		}
+		formatter.EndClass();
+		formatter.AddLine("void Render" + tmpl.identifier + "(const " + tmpl.identifier +
+						  "Variables& variables, std::string* output);");
+		formatter.EndLine();
+	}
+	formatter.EndNamespace();
+	formatter.EndNamespace();
+	formatter.EndLine();
+
+	formatter.AddComment("编译为插件时由NativeTemplateRegistry::LoadPlugin查找");
+	formatter.AddLine("extern \"C\" CODE_GENERATOR_NATIVE_EXPORT const code_generator::NativeTemplateEntry* "
+					  CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL "(size_t* count);");
+	formatter.EndLine();
+	formatter.EndIfDef();
+}
+
+void NativeTemplateCompiler::WriteSource(Formatter& formatter, const std::string& header_name) const {
+	formatter.AddComment("由cppcodegen --compile-templates生成，请勿手工修改");
+	formatter.Include("\"" + header_name + "\"");
+	formatter.EndLine();
+
+	formatter.Namespace("code_generator");
+	formatter.Namespace("native_templates");
+	for (const auto& tmpl : templates_) {
+		WriteRenderer(formatter, tmpl);
+		formatter.EndLine();
+	}
+
+	formatter.AddLine("namespace {");
+	formatter.Indent();
+	for (const auto& tmpl : templates_) {
+		formatter.OpenBlockInternal("void Render" + tmpl.identifier +
+									"Generic(std::initializer_list<const VariableTable*> tables, std::string* output)");
+		formatter.AddLine(tmpl.identifier + "Variables variables;");
+		for (const auto& variable : tmpl.variables) {
+			formatter.AddLine("variables." + variable.member + " = NativeTemplateLookup(tables, " +
+							  QuoteLiteral(variable.name) + ", " + QuoteLiteral("${" + variable.name + "}") + ");");
+		}
+		formatter.AddLine("Render" + tmpl.identifier + "(variables, output);");
+		formatter.CloseBlock();
+		formatter.EndLine();
+	}
+
+	formatter.OpenBlockInternal("const NativeTemplateEntry kTemplates[] =");
+	for (const auto& tmpl : templates_) {
+		formatter.AddLine("{ " + QuoteLiteral(tmpl.name) + ", " + QuoteLiteral(tmpl.source_hash) + ", &Render" +
+						  tmpl.identifier + "Generic },");
+	}
+	formatter.CloseBlock(";");
+	formatter.AddLine("const size_t kTemplateCount = sizeof(kTemplates) / sizeof(kTemplates[0]);");
+	formatter.EndLine();
+	formatter.AddComment("编译进程序时静态注册，编译为插件时由宿主加载后注册");
+	formatter.IfNDef("CODE_GENERATOR_NATIVE_TEMPLATES_PLUGIN");
+	formatter.AddLine("const NativeTemplateRegistrar kRegistrar(kTemplates, kTemplateCount);");
+	formatter.EndIfDef();
+	formatter.Outdent();
+	formatter.AddLine("} // namespace");
+	formatter.EndNamespace();
+	formatter.EndNamespace();
+	formatter.EndLine();
+
+	formatter.OpenBlockInternal("extern \"C\" const code_generator::NativeTemplateEntry* "
+								CODE_GENERATOR_NATIVE_TEMPLATES_SYMBOL "(size_t* count)");
+	formatter.AddLine("*count = code_generator::native_templates::kTemplateCount;");
+	formatter.AddLine("return code_generator::native_templates::kTemplates;");
+	formatter.CloseBlock();
+}
+
+void NativeTemplateCompiler::WriteRenderer(Formatter& formatter, const Template& tmpl) const {
+	formatter.OpenBlockInternal("void Render" + tmpl.identifier + "(const " + tmpl.identifier +
+								"Variables& variables, std::string* output)");
+
+	// 结果长度在渲染前即可算出，一次分配
+	std::vector<size_t> uses(tmpl.variables.size(), 0);
+	for (const auto& segment : tmpl.segments) {
+		if (segment.is_variable) {
+			++uses[segment.variable];
+		}
+	}
+	std::string size_expression = std::to_string(tmpl.literal_size);
+	for (size_t i = 0; i < tmpl.variables.size(); ++i) {
+		size_expression += " + variables." + tmpl.variables[i].member + ".size()";
+		if (uses[i] > 1) {
+			size_expression += " * " + std::to_string(uses[i]);
+		}
+	}
+	formatter.AddLine("output->reserve(output->size() + " + size_expression + ");");
+
+	for (const auto& segment : tmpl.segments) {
+		if (segment.is_variable) {
+			const std::string& member = tmpl.variables[segment.variable].member;
+			formatter.AddLine("output->append(variables." + member + ".data(), variables." + member + ".size());");
+			continue;
+		}
+
+		// 多行字面量按行拆成相邻的字符串常量
+		std::vector<std::string> lines;
+		size_t begin = 0;
+		while (begin < segment.text.size()) {
+			size_t end = segment.text.find('\n', begin);
+			end = end == std::string::npos ? segment.text.size() : end + 1;
+			lines.push_back(QuoteLiteral(segment.text.substr(begin, end - begin)));
+			begin = end;
+		}
+		std::string length = ", " + std::to_string(segment.text.size()) + ");";
+		if (lines.size() == 1) {
+			formatter.AddLine("output->append(" + lines[0] + length);
+			continue;
+		}
+		formatter.AddLine("output->append(" + lines[0]);
+		formatter.Indent();
+		for (size_t i = 1; i + 1 < lines.size(); ++i) {
+			formatter.AddLine(lines[i]);
+		}
+		formatter.AddLine(lines.back() + length);
+		formatter.Outdent();
+	}
+
+	formatter.CloseBlock();
+}
+
+std::string NativeTemplateCompiler::ToIdentifier(const std::string& name, bool camel_case) {
+	std::string result;
+	bool upper_next = true;
+	for (char c : name) {
+		if (std::isalnum(static_cast<unsigned char>(c))) {
+			result += camel_case && upper_next ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+			upper_next = false;
+		} else if (camel_case) {
+			upper_next = true;
+		} else {
+			result += '_';
+		}
+	}
+	if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))) {
+		result = (camel_case ? "T" : "v_") + result;
+	}
+	if (IsCppKeyword(result)) {
+		result += '_';
+	}
+	return result;
+}
+
+std::string NativeTemplateCompiler::QuoteLiteral(const std::string& text) {
+	std::string result = "\"";
+	for (char c : text) {
+		switch (c) {
+		case '"': result += "\\\""; break;
+		case '\\': result += "\\\\"; break;
+		case '\n': result += "\\n"; break;
+		case '\r': result += "\\r"; break;
+		case '\t': result += "\\t"; break;
+		case '?': result += "\\?"; break;	// 避免C++11模式下的三字符组
+		default:
+			if (static_cast<unsigned char>(c) < 0x20 || c == 0x7f) {
+				// 固定三位八进制，后面的数字不会被当作转义的一部分
+				char escape[8];
+				std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+				result += escape;
+			} else {
+				result += c;
+			}
+		}
+	}
+	return result + "\"";
+}
+
+} // namespace code_generator
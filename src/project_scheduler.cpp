@@ -0,0 +1,233 @@
+#include "code_generator/project_scheduler.h"
+#include "code_generator/config_validator.h"
+#include "code_generator/enhanced_cpp_generator.h"
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+
+namespace code_generator {
+
+namespace {
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 与EnhancedCppGenerator的默认输出目录一致
+const char* kDefaultOutputDirectory = "./generated";
+
+// "gen"、"./gen/"和指向同一目录的符号链接得到相同的结果
+std::string NormalizeDirectory(const std::string& directory) {
+	boost::filesystem::path path(directory);
+	path.remove_trailing_separator();
+	path = boost::filesystem::absolute(path);
+	boost::system::error_code ec;
+	boost::filesystem::path canonical = boost::filesystem::weakly_canonical(path, ec);
+	return ec ? path.lexically_normal().string() : canonical.string();
+}
+
+} // namespace
+
+ProjectScheduler::ProjectScheduler(size_t jobs)
+		: library_cache_(std::make_shared<CodeLibraryCache>()), total_elapsed_ms_(0), incremental_(false),
+		  write_if_changed_(false), streaming_(false), validate_only_(false), use_model_arena_(false) {
+	size_t workers = ThreadPool::WorkersForJobs(jobs);
+	if (workers > 0) {
+		thread_pool_ = std::make_shared<ThreadPool>(workers);
+	}
+}
+
+void ProjectScheduler::AddConfig(const std::string& config_file) {
+	config_files_.push_back(config_file);
+}
+
+bool ProjectScheduler::Run() {
+	auto start = std::chrono::steady_clock::now();
+
+	results_.clear();
+	results_.resize(config_files_.size());
+	parsers_.clear();
+	parsers_.resize(config_files_.size());
+
+	// 写入同一目录的项目会争用生成的文件和.codegen_manifest，不同组并行，组内串行；
+	// 只校验时不写文件，每个项目单独成组
+	std::vector<std::vector<size_t>> groups;
+	std::vector<char> rejected(config_files_.size(), 0);
+	if (validate_only_) {
+		groups.resize(config_files_.size());
+		for (size_t i = 0; i < config_files_.size(); ++i) {
+			groups[i].push_back(i);
+		}
+	} else {
+		GroupByOutputDirectory(&groups, &rejected);
+	}
+
+	auto run_group = [this, &groups, &rejected](size_t group) {
+		for (size_t index : groups[group]) {
+			if (!rejected[index]) {
+				RunProject(index);
+			}
+		}
+	};
+	if (thread_pool_) {
+		thread_pool_->ParallelFor(groups.size(), run_group);
+	} else {
+		for (size_t i = 0; i < groups.size(); ++i) {
+			run_group(i);
+		}
+	}
+	parsers_.clear();
+
+	total_elapsed_ms_ = ElapsedMs(start);
+
+	for (const auto& result : results_) {
+		if (!result.success) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ProjectScheduler::GroupByOutputDirectory(std::vector<std::vector<size_t>>* groups, std::vector<char>* rejected) {
+	std::vector<std::string> directories(config_files_.size());
+	auto load = [this, &directories](size_t i) { directories[i] = LoadOutputDirectory(i); };
+	if (thread_pool_) {
+		thread_pool_->ParallelFor(config_files_.size(), load);
+	} else {
+		for (size_t i = 0; i < config_files_.size(); ++i) {
+			load(i);
+		}
+	}
+
+	// 输出目录 -> 组号
+	std::unordered_map<std::string, size_t> group_of;
+	// 每组中已生成的输出文件 -> 生成它的配置文件
+	std::vector<std::unordered_map<std::string, std::string>> outputs;
+	for (size_t i = 0; i < config_files_.size(); ++i) {
+		auto inserted = group_of.emplace(directories[i], groups->size());
+		if (inserted.second) {
+			groups->emplace_back();
+			outputs.emplace_back();
+		}
+		size_t group = inserted.first->second;
+		(*groups)[group].push_back(i);
+		if (!parsers_[i]) {
+			continue;
+		}
+
+		// 同一配置内的重复路径由配置校验报告，这里只检查项目之间的冲突
+		std::vector<std::string> paths;
+		for (const auto& file_config : parsers_[i]->GetProjectConfig().files) {
+			paths.push_back(file_config.filename);
+			if (file_config.type == "dual") {
+				paths.push_back(ConfigValidator::SourceFilename(file_config));
+			}
+		}
+		std::string conflicts;
+		for (const auto& path : paths) {
+			auto it = outputs[group].find(path);
+			if (it != outputs[group].end() && it->second != config_files_[i]) {
+				conflicts += "Error: output file " + path + " in " + directories[i] + " is also generated by " +
+							 it->second + "\n";
+			}
+		}
+		if (!conflicts.empty()) {
+			ProjectResult& result = results_[i];
+			result.config_file = config_files_[i];
+			result.messages = conflicts;
+			(*rejected)[i] = 1;
+			parsers_[i].reset();
+			continue;
+		}
+		for (const auto& path : paths) {
+			outputs[group].emplace(path, config_files_[i]);
+		}
+	}
+}
+
+std::string ProjectScheduler::LoadOutputDirectory(size_t index) {
+	std::string output_dir;
+	auto parser = std::make_shared<ConfigParser>();
+	if (!config_cache_dir_.empty()) {
+		parser->SetCacheDirectory(config_cache_dir_);
+	}
+	// 加载失败时不记录错误，生成时重新加载并报告
+	if (streaming_) {
+		// 拿到项目设置后立即停止，文件元素留给生成时逐个处理
+		parser->LoadStreaming(config_files_[index],
+							  [&output_dir](const CodeGenConfig::ProjectConfig& project_config) {
+								  output_dir = project_config.output_dir;
+								  return false;
+							  },
+							  [](CodeGenConfig::FileConfig&&) { return false; });
+	} else {
+		// GenerateFromConfig会完整校验，加载时不再重复检查
+		parser->SetValidateOnLoad(false);
+		if (parser->LoadFromFile(config_files_[index])) {
+			output_dir = parser->GetProjectConfig().output_dir;
+			parsers_[index] = parser;
+		}
+	}
+	return NormalizeDirectory(output_dir.empty() ? kDefaultOutputDirectory : output_dir);
+}
+
+void ProjectScheduler::RunProject(size_t index) {
+	auto start = std::chrono::steady_clock::now();
+	ProjectResult& result = results_[index];
+	result.config_file = config_files_[index];
+
+	std::ostringstream messages;
+	try {
+		EnhancedCppGenerator generator;
+		generator.SetErrorStream(&messages);
+		generator.SetThreadPool(thread_pool_);
+		generator.SetCodeLibraryCache(library_cache_);
+		generator.SetIncremental(incremental_);
+		generator.SetWriteIfChanged(write_if_changed_);
+		generator.SetStreaming(streaming_);
+		generator.SetUseModelArena(use_model_arena_);
+		generator.SetConfigCacheDirectory(config_cache_dir_);
+		if (validate_only_) {
+			result.success = generator.ValidateConfigFile(result.config_file);
+		} else if (parsers_[index]) {
+			// 分组时已加载
+			generator.SetConfigParser(parsers_[index]);
+			result.success = generator.GenerateFromConfig(parsers_[index]->GetProjectConfig());
+			parsers_[index].reset();
+		} else {
+			result.success = generator.GenerateFromConfigFile(result.config_file);
+		}
+	} catch (const std::exception& e) {
+		messages << "Error: " << e.what() << std::endl;
+		result.success = false;
+	}
+
+	result.messages = messages.str();
+	result.elapsed_ms = ElapsedMs(start);
+}
+
+void ProjectScheduler::PrintResults(std::ostream& out) const {
+	for (const auto& result : results_) {
+		out << result.messages;
+		out << "config file:(" << result.success << ")" << result.config_file
+			<< " " << static_cast<long>(result.elapsed_ms) << "ms" << std::endl;
+	}
+}
+
+void ProjectScheduler::PrintSummary(std::ostream& out) const {
+	size_t succeeded = 0;
+	for (const auto& result : results_) {
+		if (result.success) {
+			++succeeded;
+		}
+	}
+
+	out << "projects: " << results_.size()
+		<< ", succeeded: " << succeeded
+		<< ", failed: " << results_.size() - succeeded
+		<< ", library files: " << library_cache_->Size()
+		<< " (" << library_cache_->Bytes() << " bytes mapped)"
+		<< ", elapsed: " << static_cast<long>(total_elapsed_ms_) << "ms" << std::endl;
+}
+
+} // namespace code_generator
@@ -92,20 +92,22 @@ bool StreamUtil::ReadToString(ZeroCopyInputStreamPtr input, std::string* output)
 }
 
 bool StreamUtil::ReadFileToString(const std::string& filename, std::string* content) {
-	FileInputStream input(filename);
-	if (!input.IsOpen()) {
+	// 文件流构造失败会抛出异常，这里转换为返回值
+	try {
+		ZeroCopyInputStreamPtr input(new FileInputStream(filename));
+		return ReadToString(input, content);
+	} catch (const std::exception& e) {
 		return false;
 	}
-	ZeroCopyInputStreamPtr ptr(&input);
-	return ReadToString(ptr, content);
 }
 
 bool StreamUtil::WriteStringToFile(const std::string& content, const std::string& filename) {
-	FileOutputStream output(filename);
-	if (!output.IsOpen()) {
+	try {
+		FileOutputStream output(filename);
+		return output.WriteRaw(content.data(), static_cast<int>(content.size())) && output.Flush();
+	} catch (const std::exception& e) {
 		return false;
 	}
-	return output.WriteRaw(content.data(), static_cast<int>(content.size()));
 }
 
 bool StreamUtil::CopyStream(ZeroCopyInputStreamPtr input, ZeroCopyOutputStreamPtr output) {
@@ -0,0 +1,27 @@
+#include "code_generator/symbol_table.h"
+
+namespace code_generator {
+
+Symbol::Symbol(SymbolTable& table, const std::string& text) : Symbol(table.Intern(text)) {}
+
+const std::string& Symbol::EmptyString() {
+	static const std::string empty;
+	return empty;
+}
+
+Symbol SymbolTable::Intern(const std::string& text) {
+	// 空字符串与默认构造的Symbol相同
+	if (text.empty()) {
+		return Symbol();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	return Symbol(&*strings_.insert(text).first);
+}
+
+size_t SymbolTable::Size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return strings_.size();
+}
+
+} // namespace code_generator
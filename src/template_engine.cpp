@@ -0,0 +1,374 @@
+#include "code_generator/template_engine.h"
+
+namespace code_generator {
+
+VariableTable::VariableTable(const std::map<std::string, std::string>& variables) {
+	Assign(variables);
+}
+
+void VariableTable::Assign(const std::map<std::string, std::string>& variables) {
+	values_.clear();
+	values_.reserve(variables.size());
+	for (const auto& iter : variables) {
+		values_.emplace(iter.first, iter.second);
+	}
+}
+
+namespace {
+
+const uint32_t kNoTarget = 0;
+
+// 循环帧：当前遍历的数组和下标
+struct LoopFrame {
+	const boost::json::array* items;
+	size_t index;
+};
+
+boost::string_view Trim(boost::string_view text) {
+	while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+		text.remove_prefix(1);
+	}
+	while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+		text.remove_suffix(1);
+	}
+	return text;
+}
+
+// 在循环元素和结构化变量中查找，内层循环优先
+const boost::json::value* FindValue(boost::string_view name, const std::vector<LoopFrame>& frames,
+									const boost::json::object* data) {
+	boost::json::string_view key(name.data(), name.size());
+	for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+		const boost::json::value& item = (*it->items)[it->index];
+		if (name == "this") {
+			return &item;
+		}
+		if (item.is_object()) {
+			const boost::json::value* value = item.as_object().if_contains(key);
+			if (value) {
+				return value;
+			}
+		}
+	}
+	return data ? data->if_contains(key) : nullptr;
+}
+
+// 标量转字符串，数组和对象不能直接输出
+bool ScalarToString(const boost::json::value& value, std::string* scratch, const std::string** result) {
+	if (value.is_string()) {
+		const boost::json::string& str = value.as_string();
+		scratch->assign(str.data(), str.size());
+	} else if (value.is_bool()) {
+		*scratch = value.as_bool() ? "true" : "false";
+	} else if (value.is_int64()) {
+		*scratch = std::to_string(value.as_int64());
+	} else if (value.is_uint64()) {
+		*scratch = std::to_string(value.as_uint64());
+	} else if (value.is_double()) {
+		*scratch = boost::json::serialize(value);
+	} else if (value.is_null()) {
+		scratch->clear();
+	} else {
+		return false;
+	}
+	*result = scratch;
+	return true;
+}
+
+bool IsTruthy(const boost::json::value& value) {
+	if (value.is_bool()) return value.as_bool();
+	if (value.is_null()) return false;
+	if (value.is_string()) return !value.as_string().empty();
+	if (value.is_array()) return !value.as_array().empty();
+	if (value.is_object()) return !value.as_object().empty();
+	if (value.is_int64()) return value.as_int64() != 0;
+	if (value.is_uint64()) return value.as_uint64() != 0;
+	return value.as_double() != 0;
+}
+
+} // namespace
+
+CompiledTemplate::CompiledTemplate(std::string text)
+		: text_(std::move(text)), literal_size_(0), has_sections_(false) {
+	Compile(true);
+	if (!error_.empty()) {
+		// 段落不匹配时忽略所有{{...}}标记，只替换变量
+		program_.clear();
+		literal_size_ = 0;
+		has_sections_ = false;
+		Compile(false);
+	}
+}
+
+bool CompiledTemplate::HasVariables() const {
+	for (const auto& instruction : program_) {
+		if (instruction.op != OpCode::LITERAL) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void CompiledTemplate::Compile(bool sections_enabled) {
+	std::vector<size_t> sections;
+	size_t literal_begin = 0;
+	size_t pos = 0;
+
+	while (pos < text_.size()) {
+		size_t variable = text_.find("${", pos);
+		size_t tag = sections_enabled ? text_.find("{{", pos) : std::string::npos;
+		if (variable == std::string::npos && tag == std::string::npos) {
+			break;
+		}
+
+		if (variable < tag) {
+			size_t end = text_.find('}', variable + 2);
+			if (end == std::string::npos) {
+				break;
+			}
+			// "${ ${A}"这类文本取离右括号最近的"${"
+			size_t start = text_.rfind("${", end);
+			EmitLiteral(literal_begin, start);
+			Emit(OpCode::VARIABLE, start + 2, end - start - 2);
+			pos = literal_begin = end + 1;
+			continue;
+		}
+
+		size_t end = text_.find("}}", tag + 2);
+		if (end != std::string::npos && CompileTag(tag, end, &literal_begin, &sections)) {
+			pos = literal_begin;
+		} else {
+			pos = tag + 1;
+		}
+		if (!error_.empty()) {
+			break;
+		}
+	}
+
+	if (error_.empty() && !sections.empty()) {
+		error_ = "unclosed {{#" + std::string(program_[sections.back()].op == OpCode::EACH ? "each" : "if") + "}}";
+	}
+	EmitLiteral(literal_begin, text_.size());
+}
+
+void CompiledTemplate::EmitLiteral(size_t begin, size_t end) {
+	if (end > begin) {
+		Emit(OpCode::LITERAL, begin, end - begin);
+		literal_size_ += end - begin;
+	}
+}
+
+void CompiledTemplate::Emit(OpCode op, size_t offset, size_t length, size_t target) {
+	Instruction instruction = { op, static_cast<uint32_t>(offset), static_cast<uint32_t>(length),
+								static_cast<uint32_t>(target) };
+	program_.push_back(instruction);
+}
+
+bool CompiledTemplate::CompileTag(size_t tag_begin, size_t tag_end, size_t* literal_begin,
+								  std::vector<size_t>* sections) {
+	boost::string_view content = Trim(boost::string_view(text_.data() + tag_begin + 2, tag_end - tag_begin - 2));
+	boost::string_view keyword = content.substr(0, content.find(' '));
+	boost::string_view name = Trim(content.substr(keyword.size()));
+	size_t name_offset = name.empty() ? 0 : name.data() - text_.data();
+
+	bool opens = (keyword == "#each" || keyword == "#if") && !name.empty();
+	bool closes = keyword == "else" || keyword == "/each" || keyword == "/if";
+	if (!opens && !(closes && name.empty())) {
+		return false;
+	}
+
+	EmitLiteral(*literal_begin, tag_begin);
+	*literal_begin = tag_end + 2;
+	has_sections_ = true;
+
+	if (keyword == "#each") {
+		sections->push_back(program_.size());
+		Emit(OpCode::EACH, name_offset, name.size(), kNoTarget);
+	} else if (keyword == "#if") {
+		sections->push_back(program_.size());
+		Emit(OpCode::IF, name_offset, name.size(), kNoTarget);
+	} else if (keyword == "/each") {
+		if (sections->empty() || program_[sections->back()].op != OpCode::EACH) {
+			error_ = "unexpected {{/each}} at offset " + std::to_string(tag_begin);
+			return true;
+		}
+		size_t each = sections->back();
+		sections->pop_back();
+		Emit(OpCode::NEXT, 0, 0, each + 1);
+		program_[each].target = static_cast<uint32_t>(program_.size());
+	} else if (keyword == "else") {
+		if (sections->empty() || program_[sections->back()].op != OpCode::IF) {
+			error_ = "unexpected {{else}} at offset " + std::to_string(tag_begin);
+			return true;
+		}
+		size_t branch = sections->back();
+		sections->back() = program_.size();
+		Emit(OpCode::JUMP, 0, 0, kNoTarget);
+		program_[branch].target = static_cast<uint32_t>(program_.size());
+	} else {
+		if (sections->empty() || (program_[sections->back()].op != OpCode::IF &&
+								  program_[sections->back()].op != OpCode::JUMP)) {
+			error_ = "unexpected {{/if}} at offset " + std::to_string(tag_begin);
+			return true;
+		}
+		program_[sections->back()].target = static_cast<uint32_t>(program_.size());
+		sections->pop_back();
+	}
+	return true;
+}
+
+void CompiledTemplate::Render(std::initializer_list<const VariableTable*> tables, std::string* output,
+							  const boost::json::object* data) const {
+	if (!has_sections_ && !data) {
+		// 无段落时先计算结果长度，一次分配
+		size_t total = literal_size_;
+		for (const auto& instruction : program_) {
+			if (instruction.op == OpCode::VARIABLE) {
+				const std::string* value = Lookup(boost::string_view(text_.data() + instruction.offset, instruction.length), tables);
+				total += value ? value->size() : instruction.length + 3;
+			}
+		}
+		output->reserve(output->size() + total);
+	} else {
+		output->reserve(output->size() + literal_size_);
+	}
+
+	Execute(tables, data, output);
+}
+
+std::string CompiledTemplate::Render(std::initializer_list<const VariableTable*> tables,
+									 const boost::json::object* data) const {
+	std::string output;
+	Render(tables, &output, data);
+	return output;
+}
+
+void CompiledTemplate::Execute(std::initializer_list<const VariableTable*> tables, const boost::json::object* data,
+							   std::string* output) const {
+	std::vector<LoopFrame> frames;
+	std::string scratch;
+	size_t pc = 0;
+
+	while (pc < program_.size()) {
+		const Instruction& instruction = program_[pc];
+		boost::string_view name(text_.data() + instruction.offset, instruction.length);
+
+		switch (instruction.op) {
+		case OpCode::LITERAL:
+			output->append(text_, instruction.offset, instruction.length);
+			++pc;
+			break;
+
+		case OpCode::VARIABLE: {
+			const std::string* value = nullptr;
+			if (!frames.empty() && name == "@index") {
+				scratch = std::to_string(frames.back().index);
+				value = &scratch;
+			} else {
+				// 循环元素优先，其次是普通变量，最后是顶层结构化变量
+				const boost::json::value* item = frames.empty() ? nullptr : FindValue(name, frames, nullptr);
+				if (!item || !ScalarToString(*item, &scratch, &value)) {
+					value = Lookup(name, tables);
+				}
+				if (!value && data) {
+					const boost::json::value* top = FindValue(name, std::vector<LoopFrame>(), data);
+					if (top && !ScalarToString(*top, &scratch, &value)) {
+						value = nullptr;
+					}
+				}
+			}
+			if (value) {
+				output->append(*value);
+			} else {
+				output->append(text_, instruction.offset - 2, instruction.length + 3);
+			}
+			++pc;
+			break;
+		}
+
+		case OpCode::EACH: {
+			const boost::json::value* items = FindValue(name, frames, data);
+			if (items && items->is_array() && !items->as_array().empty()) {
+				LoopFrame frame = { &items->as_array(), 0 };
+				frames.push_back(frame);
+				++pc;
+			} else {
+				pc = instruction.target;
+			}
+			break;
+		}
+
+		case OpCode::NEXT:
+			if (++frames.back().index < frames.back().items->size()) {
+				pc = instruction.target;
+			} else {
+				frames.pop_back();
+				++pc;
+			}
+			break;
+
+		case OpCode::IF: {
+			bool truthy = false;
+			if (!frames.empty() && name == "@first") {
+				truthy = frames.back().index == 0;
+			} else if (!frames.empty() && name == "@last") {
+				truthy = frames.back().index + 1 == frames.back().items->size();
+			} else {
+				const boost::json::value* value = FindValue(name, frames, data);
+				if (value) {
+					truthy = IsTruthy(*value);
+				} else {
+					const std::string* text = Lookup(name, tables);
+					truthy = text && !text->empty() && *text != "false" && *text != "0";
+				}
+			}
+			pc = truthy ? pc + 1 : instruction.target;
+			break;
+		}
+
+		case OpCode::JUMP:
+			pc = instruction.target;
+			break;
+		}
+	}
+}
+
+void CompiledTemplate::RenderText(boost::string_view text, std::initializer_list<const VariableTable*> tables,
+								  std::string* output) {
+	output->reserve(output->size() + text.size());
+
+	size_t pos = 0;
+	while (pos < text.size()) {
+		size_t start = text.find("${", pos);
+		size_t end = start == boost::string_view::npos ? boost::string_view::npos : text.find('}', start + 2);
+		if (end == boost::string_view::npos) {
+			output->append(text.data() + pos, text.size() - pos);
+			break;
+		}
+
+		start = text.rfind("${", end);
+		output->append(text.data() + pos, start - pos);
+		const std::string* value = Lookup(text.substr(start + 2, end - start - 2), tables);
+		if (value) {
+			output->append(*value);
+		} else {
+			output->append(text.data() + start, end - start + 1);
+		}
+		pos = end + 1;
+	}
+}
+
+const std::string* CompiledTemplate::Lookup(boost::string_view name, std::initializer_list<const VariableTable*> tables) {
+	for (const VariableTable* table : tables) {
+		if (!table) {
+			continue;
+		}
+		const std::string* value = table->Find(name);
+		if (value) {
+			return value;
+		}
+	}
+	return nullptr;
+}
+
+} // namespace code_generator
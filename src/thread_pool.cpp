@@ -0,0 +1,172 @@
+#include "code_generator/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace code_generator {
+
+namespace {
+
+// 当前线程所属的线程池及其队列下标，非工作线程为nullptr
+thread_local ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_queue_index = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count)
+		: pending_(0), next_queue_(0), stop_(false) {
+	if (thread_count == 0) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (size_t i = 0; i < thread_count; ++i) {
+		queues_.emplace_back(new WorkerQueue());
+	}
+	for (size_t i = 0; i < thread_count; ++i) {
+		workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		stop_ = true;
+	}
+	wake_cv_.notify_all();
+
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+}
+
+size_t ThreadPool::WorkersForJobs(size_t jobs) {
+	if (jobs == 0) {
+		jobs = std::max(1u, std::thread::hardware_concurrency());
+	}
+	return jobs > 1 ? jobs - 1 : 0;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+	WorkerQueue& queue = *queues_[CurrentQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	pending_.fetch_add(1);
+	{
+		// 加锁后再通知，避免工作线程检查条件与进入等待之间丢失唤醒
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+	}
+	wake_cv_.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+	if (count == 0) {
+		return;
+	}
+
+	struct State {
+		std::atomic<size_t> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+	auto state = std::make_shared<State>();
+	state->remaining.store(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		Submit([state, &fn, i]() {
+			try {
+				fn(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error) {
+					state->error = std::current_exception();
+				}
+			}
+			if (state->remaining.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->done.notify_all();
+			}
+		});
+	}
+
+	// 等待期间调用线程也执行任务
+	while (state->remaining.load() > 0) {
+		if (TryRunOne(CurrentQueue())) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait_for(lock, std::chrono::milliseconds(1),
+			[&state]() { return state->remaining.load() == 0; });
+	}
+
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+	tls_pool = this;
+	tls_queue_index = index;
+
+	while (true) {
+		if (TryRunOne(index)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex_);
+		if (stop_ && pending_.load() == 0) {
+			break;
+		}
+		wake_cv_.wait(lock, [this]() { return stop_ || pending_.load() > 0; });
+	}
+
+	tls_pool = nullptr;
+}
+
+bool ThreadPool::TryRunOne(size_t preferred) {
+	std::function<void()> task;
+
+	// 先取本地队列队尾（最近提交，缓存友好）
+	{
+		WorkerQueue& queue = *queues_[preferred];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+	}
+
+	// 再从其他队列队首窃取
+	for (size_t i = 1; !task && i < queues_.size(); ++i) {
+		WorkerQueue& queue = *queues_[(preferred + i) % queues_.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+
+	if (!task) {
+		return false;
+	}
+
+	pending_.fetch_sub(1);
+	try {
+		task();
+	} catch (...) {
+	}
+	return true;
+}
+
+size_t ThreadPool::CurrentQueue() {
+	if (tls_pool == this) {
+		return tls_queue_index;
+	}
+	// 外部线程提交的任务轮流放入各队列
+	return next_queue_.fetch_add(1) % queues_.size();
+}
+
+} // namespace code_generator
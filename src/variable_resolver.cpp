@@ -0,0 +1,153 @@
+#include "code_generator/variable_resolver.h"
+
+namespace code_generator {
+
+namespace {
+
+// 从pos开始展开占位符。in_name为true时展开的是${...}中的名称，遇到与之匹配的'}'时返回其位置；
+// 到达末尾仍未找到时返回npos。lookup返回nullptr的占位符按原文输出
+template <typename Lookup>
+size_t ExpandRange(boost::string_view text, size_t pos, bool in_name, Lookup& lookup, std::string* output) {
+	size_t literal_begin = pos;
+	while (pos < text.size()) {
+		char c = text[pos];
+		if (in_name && c == '}') {
+			output->append(text.data() + literal_begin, pos - literal_begin);
+			return pos;
+		}
+		if (c != '$' || pos + 1 >= text.size() || text[pos + 1] != '{') {
+			++pos;
+			continue;
+		}
+
+		output->append(text.data() + literal_begin, pos - literal_begin);
+		std::string name;
+		size_t close = ExpandRange(text, pos + 2, true, lookup, &name);
+		if (close == boost::string_view::npos) {
+			if (in_name) {
+				// 内层找不到'}'时外层同样找不到
+				return boost::string_view::npos;
+			}
+			// 没有结束的"${"按字面量输出，继续展开其后的内容
+			output->append("${", 2);
+			pos += 2;
+			literal_begin = pos;
+			continue;
+		}
+
+		const std::string* value = lookup(boost::string_view(name));
+		if (value) {
+			output->append(*value);
+		} else {
+			output->append(text.data() + pos, close + 1 - pos);
+		}
+		pos = close + 1;
+		literal_begin = pos;
+	}
+
+	output->append(text.data() + literal_begin, text.size() - literal_begin);
+	return in_name ? boost::string_view::npos : text.size();
+}
+
+} // namespace
+
+VariableResolver::VariableResolver(const StringMap& variables) {
+	variables_.reserve(variables.size());
+	for (const auto& iter : variables) {
+		variables_[iter.first].raw = iter.second;
+	}
+}
+
+void VariableResolver::Define(boost::string_view name, const std::string& raw_value) {
+	ResetStates();
+	Variable& variable = variables_[name];
+	variable.raw = raw_value;
+	variable.provider = Provider();
+}
+
+void VariableResolver::DefineComputed(boost::string_view name, Provider provider) {
+	ResetStates();
+	Variable& variable = variables_[name];
+	variable.raw.clear();
+	variable.provider = std::move(provider);
+}
+
+const std::string* VariableResolver::Resolve(boost::string_view name) {
+	auto it = variables_.find(name);
+	if (it == variables_.end()) {
+		return nullptr;
+	}
+
+	// 求值过程中不会插入新变量，引用保持有效
+	Variable& variable = it->second;
+	switch (variable.state) {
+	case State::DONE:
+		return &variable.Result();
+	case State::RESOLVING:
+		if (error_.empty()) {
+			for (auto path = resolving_.begin(); path != resolving_.end(); ++path) {
+				if (*path == name) {
+					for (; path != resolving_.end(); ++path) {
+						error_ += *path + " -> ";
+					}
+					break;
+				}
+			}
+			error_.append(name.data(), name.size());
+		}
+		return nullptr;
+	case State::PENDING:
+		break;
+	}
+
+	has_results_ = true;
+	variable.state = State::RESOLVING;
+	resolving_.push_back(it->first);
+	if (variable.provider) {
+		variable.value = variable.provider();
+		variable.expanded = true;
+	} else if (variable.raw.find("${") != std::string::npos) {
+		std::string value;
+		Expand(variable.raw, &value);
+		variable.value.swap(value);
+		variable.expanded = true;
+	}
+	resolving_.pop_back();
+	variable.state = State::DONE;
+	return &variable.Result();
+}
+
+void VariableResolver::Expand(boost::string_view text, std::string* output) {
+	output->reserve(output->size() + text.size());
+	auto lookup = [this](boost::string_view name) { return Resolve(name); };
+	ExpandRange(text, 0, false, lookup, output);
+}
+
+void VariableResolver::ResolveAll(StringMap* values) {
+	values->reserve(values->size() + variables_.size());
+	for (const auto& iter : variables_) {
+		const std::string* value = Resolve(iter.first);
+		(*values)[iter.first] = value ? *value : iter.second.raw;
+	}
+}
+
+void VariableResolver::ExpandText(boost::string_view text, const VariableTable& table, std::string* output) {
+	output->reserve(output->size() + text.size());
+	auto lookup = [&table](boost::string_view name) { return table.Find(name); };
+	ExpandRange(text, 0, false, lookup, output);
+}
+
+void VariableResolver::ResetStates() {
+	if (!has_results_) {
+		return;
+	}
+	for (auto& iter : variables_) {
+		iter.second.value.clear();
+		iter.second.expanded = false;
+		iter.second.state = State::PENDING;
+	}
+	error_.clear();
+	has_results_ = false;
+}
+
+} // namespace code_generator